@@ -21,30 +21,33 @@ static void PrintUsage(const char* Prog)
     printf("    -q  quiet mode\n");
     printf("    -e  echo puzzle input to stdout, then exit\n");
     printf("    -b  benchmark mode, reports best time from many runs\n");
+    printf("    -t  number of threads for multithreaded solvers, e.g. -t4\n");
 }
 
 static char* ReadStandardInput(void)
 {
     size_t Length = 0;
-    size_t Capacity = 128;
+    size_t Capacity = 4096;
     char* Chars = (char*)malloc(Capacity);
-    Chars[0] = '\0';
-    char Buffer[128];
-    while(fgets(Buffer, sizeof(Buffer), stdin))
+    for(;;)
     {
-        size_t BufferLength = strlen(Buffer) + 1;
-        size_t OldCapacity = Capacity;
-        while(Length + BufferLength > Capacity)
+        // Always leave room for the null terminator.
+        if(Length + 1 == Capacity)
         {
             Capacity *= 2;
+            char* NewChars = (char*)realloc(Chars, Capacity);
+            if(!NewChars)
+            {
+                free(Chars);
+                return NULL;
+            }
+            Chars = NewChars;
         }
-        if(Capacity > OldCapacity)
-        {
-            Chars = (char*)realloc(Chars, Capacity);
-        }
-        memcpy(Chars + Length, Buffer, BufferLength);
-        Length += BufferLength - 1;
+        size_t Read = fread(Chars + Length, sizeof(char), Capacity - Length - 1, stdin);
+        if(Read == 0) break;
+        Length += Read;
     }
+    Chars[Length] = '\0';
     if(!feof(stdin))
     {
         free(Chars);
@@ -57,8 +60,9 @@ static char* ReadInputFile(const char* Path)
 {
     FILE* File = fopen(Path, "rb");
     if(File == NULL) return NULL;
-    fseek(File, 0L, SEEK_END);
-    size_t Size = ftell(File);
+    // Use the 64-bit variants, as long is only 32 bits on Windows.
+    _fseeki64(File, 0, SEEK_END);
+    size_t Size = (size_t)_ftelli64(File);
     rewind(File);
     char* Buffer = (char*)malloc(Size + 1);
     if(!Buffer) return NULL;
@@ -86,6 +90,63 @@ static double Clock(void)
     return (double)Counter.QuadPart / Frequency;
 }
 
+static int ThreadCountOption = 0;
+
+int AocThreadCount(void)
+{
+    int ThreadCount = ThreadCountOption;
+    if(ThreadCount <= 0)
+    {
+        SYSTEM_INFO SystemInfo;
+        GetSystemInfo(&SystemInfo);
+        ThreadCount = (int)SystemInfo.dwNumberOfProcessors;
+    }
+    return ThreadCount < AOC_MAX_THREADS ? ThreadCount : AOC_MAX_THREADS;
+}
+
+typedef struct
+{
+    aoc_thread_fn* Fn;
+    void* User;
+    int ThreadIndex;
+    int ThreadCount;
+} thread_params;
+
+static DWORD WINAPI ThreadMain(LPVOID Param)
+{
+    thread_params* Params = (thread_params*)Param;
+    Params->Fn(Params->User, Params->ThreadIndex, Params->ThreadCount);
+    return 0;
+}
+
+void AocRunThreads(aoc_thread_fn* Fn, void* User, int ThreadCount)
+{
+    // The calling thread does the work of the first thread itself, as well as
+    // the work of any thread that couldn't be created.
+    thread_params Params[AOC_MAX_THREADS];
+    HANDLE Threads[AOC_MAX_THREADS];
+    int StartedCount = 0;
+    for(int Index = 0; Index < ThreadCount; Index++)
+    {
+        Params[Index] = (thread_params){.Fn = Fn, .User = User, .ThreadIndex = Index, .ThreadCount = ThreadCount};
+        if(Index > 0)
+        {
+            HANDLE Thread = CreateThread(NULL, 0, ThreadMain, &Params[Index], 0, NULL);
+            if(Thread) Threads[StartedCount++] = Thread;
+            else ThreadMain(&Params[Index]);
+        }
+    }
+    ThreadMain(&Params[0]);
+    if(StartedCount > 0)
+    {
+        WaitForMultipleObjects(StartedCount, Threads, TRUE, INFINITE);
+        for(int Index = 0; Index < StartedCount; Index++)
+        {
+            CloseHandle(Threads[Index]);
+        }
+    }
+}
+
 static void RunSolver(aoc_solver* Solver, const char* Input, bool Quiet, bool Benchmark)
 {
     int64_t Result;
@@ -136,6 +197,10 @@ int main(int ArgCount, const char** Args)
                 PrintUsage(Args[0]);
                 return EXIT_SUCCESS;
             case 'q': Quiet = true; break;
+            case 't':
+                ThreadCountOption = atoi(Arg + CharIndex + 1);
+                CharIndex += (int)strspn(Arg + CharIndex + 1, "0123456789");
+                break;
             default:
                 PrintUsage(Args[0]);
                 return EXIT_FAILURE;
@@ -12,3 +12,42 @@
 typedef AOC_SOLVER(aoc_solver);
 
 #define AOC_UNUSED(X) ((void)X)
+
+// Runs Fn on a number of worker threads and waits for them all to finish.
+// Each call receives its thread index and the total number of threads. The
+// thread count is set with -t, and defaults to the number of processors.
+#define AOC_MAX_THREADS (64)
+typedef void aoc_thread_fn(void* User, int ThreadIndex, int ThreadCount);
+int AocThreadCount(void);
+void AocRunThreads(aoc_thread_fn* Fn, void* User, int ThreadCount);
+
+// Signed type for indices and counts that scale with the size of the input.
+// 64-bit by default so inputs beyond 2GB can be processed; define
+// AOC_INDEX_32 to use 32-bit indices instead.
+#ifdef AOC_INDEX_32
+typedef int32_t aoc_index;
+#else
+typedef int64_t aoc_index;
+#endif
+
+// Overflow-checked arithmetic for accumulating answers. Rather than print a
+// wrapped result, these report the overflow and exit.
+static inline void AocOverflow(void)
+{
+    fprintf(stderr, "Integer overflow.\n");
+    exit(EXIT_FAILURE);
+}
+
+static inline int64_t AocAdd(int64_t A, int64_t B)
+{
+    int64_t Result;
+    if(__builtin_add_overflow(A, B, &Result)) AocOverflow();
+    return Result;
+}
+
+static inline int64_t AocMul(int64_t A, int64_t B)
+{
+    int64_t Result;
+    if(__builtin_mul_overflow(A, B, &Result)) AocOverflow();
+    return Result;
+}
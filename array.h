@@ -0,0 +1,202 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Arenas are bump allocators made from a chain of blocks. Allocations are never
+// freed individually; the whole arena is reset or freed at once.
+typedef struct arena_block
+{
+    struct arena_block* Prev;
+    size_t Used;
+    size_t Capacity;
+    max_align_t Data[];
+} arena_block;
+
+typedef struct
+{
+    arena_block* Head;
+} arena;
+
+#define ARENA_ALIGNMENT (sizeof(max_align_t))
+
+static inline size_t ArenaAlign(size_t Size)
+{
+    return (Size + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+}
+
+static inline arena_block* ArenaNewBlock(arena_block* Prev, size_t Capacity)
+{
+    arena_block* Block = (arena_block*)malloc(sizeof(arena_block) + Capacity);
+    Block->Prev = Prev;
+    Block->Used = 0;
+    Block->Capacity = Capacity;
+    return Block;
+}
+
+static inline void InitArena(arena* Arena, size_t Capacity)
+{
+    Arena->Head = ArenaNewBlock(NULL, ArenaAlign(Capacity ? Capacity : 4096));
+}
+
+static inline void FreeArena(arena* Arena)
+{
+    arena_block* Block = Arena->Head;
+    while(Block)
+    {
+        arena_block* Prev = Block->Prev;
+        free(Block);
+        Block = Prev;
+    }
+    Arena->Head = NULL;
+}
+
+static inline void ArenaReset(arena* Arena)
+{
+    // Keep only the newest (and largest) block for reuse.
+    arena_block* Head = Arena->Head;
+    arena_block* Block = Head->Prev;
+    while(Block)
+    {
+        arena_block* Prev = Block->Prev;
+        free(Block);
+        Block = Prev;
+    }
+    Head->Prev = NULL;
+    Head->Used = 0;
+}
+
+static inline void* ArenaPush(arena* Arena, size_t Size)
+{
+    Size = ArenaAlign(Size);
+    arena_block* Head = Arena->Head;
+    if(Head->Used + Size > Head->Capacity)
+    {
+        size_t Capacity = 2 * Head->Capacity;
+        if(Capacity < Size) Capacity = Size;
+        Head = Arena->Head = ArenaNewBlock(Head, Capacity);
+    }
+    void* Result = (uint8_t*)Head->Data + Head->Used;
+    Head->Used += Size;
+    return Result;
+}
+
+static inline void* ArenaResize(arena* Arena, void* Old, size_t OldSize, size_t NewSize)
+{
+    // Grow in place if this was the most recent allocation and there is room.
+    arena_block* Head = Arena->Head;
+    OldSize = ArenaAlign(OldSize);
+    NewSize = ArenaAlign(NewSize);
+    uint8_t* Top = (uint8_t*)Head->Data + Head->Used;
+    if((uint8_t*)Old + OldSize == Top && Head->Used - OldSize + NewSize <= Head->Capacity)
+    {
+        Head->Used = Head->Used - OldSize + NewSize;
+        return Old;
+    }
+    void* New = ArenaPush(Arena, NewSize);
+    memcpy(New, Old, OldSize < NewSize ? OldSize : NewSize);
+    return New;
+}
+
+// Moves an array's elements into a larger allocation. Elements stored inline
+// (or not allocated yet) are copied to the heap or arena, and never freed.
+static inline void* ArrayReallocate(void* Elements, void* Inline, size_t Count, size_t Capacity, size_t NewCapacity, size_t ElementSize, arena* Arena)
+{
+    if(Elements == NULL || Elements == Inline)
+    {
+        void* NewElements = Arena ? ArenaPush(Arena, ElementSize * NewCapacity) : malloc(ElementSize * NewCapacity);
+        if(Count) memcpy(NewElements, Elements, ElementSize * Count);
+        return NewElements;
+    }
+    if(Arena)
+    {
+        return ArenaResize(Arena, Elements, ElementSize * Capacity, ElementSize * NewCapacity);
+    }
+    return realloc(Elements, ElementSize * NewCapacity);
+}
+
+#define ARRAY_NO_INLINE(Array) NULL
+#define ARRAY_INLINE(Array) ((Array)->Inline)
+
+#define ARRAY_FUNCTIONS(Name, Prefix, Type, InlineOf, InlineCapacity) \
+    static inline void Init##Prefix##InArena(Name* Array, arena* Arena) \
+    { \
+        Array->Elements = InlineOf(Array); \
+        Array->Count = 0; \
+        Array->Capacity = InlineCapacity; \
+        Array->Arena = Arena; \
+    } \
+    static inline void Init##Prefix(Name* Array) \
+    { \
+        Init##Prefix##InArena(Array, NULL); \
+    } \
+    static inline void Free##Prefix(Name* Array) \
+    { \
+        if(!Array->Arena && Array->Elements != InlineOf(Array)) \
+        { \
+            free(Array->Elements); \
+        } \
+        Init##Prefix##InArena(Array, Array->Arena); \
+    } \
+    static inline void Prefix##Reserve(Name* Array, size_t Capacity) \
+    { \
+        if(Capacity <= Array->Capacity) return; \
+        Array->Elements = (Type*)ArrayReallocate(Array->Elements, InlineOf(Array), Array->Count, Array->Capacity, Capacity, sizeof(Type), Array->Arena); \
+        Array->Capacity = Capacity; \
+    } \
+    static inline Type* Prefix##Push(Name* Array) \
+    { \
+        if(Array->Count == Array->Capacity) \
+        { \
+            Prefix##Reserve(Array, Array->Capacity ? 2 * Array->Capacity : 8); \
+        } \
+        return &Array->Elements[Array->Count++]; \
+    } \
+    static inline void Prefix##Add(Name* Array, Type Element) \
+    { \
+        *Prefix##Push(Array) = Element; \
+    } \
+    static inline Type Prefix##Pop(Name* Array) \
+    { \
+        return Array->Elements[--Array->Count]; \
+    } \
+    static inline void Prefix##Reset(Name* Array) \
+    { \
+        Array->Count = 0; \
+    } \
+    static inline void Prefix##Swap(Name* A, Name* B) \
+    { \
+        Name Temp = *A; \
+        *A = *B; \
+        *B = Temp; \
+        if(A->Elements && A->Elements == InlineOf(B)) A->Elements = InlineOf(A); \
+        if(B->Elements && B->Elements == InlineOf(A)) B->Elements = InlineOf(B); \
+    }
+
+// Declares a growable array type Name of Type, with functions InitPrefix,
+// FreePrefix, PrefixReserve, PrefixPush, PrefixAdd, PrefixPop, PrefixReset and
+// PrefixSwap. Arrays start empty and double in capacity as they grow.
+#define ARRAY(Name, Prefix, Type) \
+    typedef struct \
+    { \
+        Type* Elements; \
+        size_t Count; \
+        size_t Capacity; \
+        arena* Arena; \
+    } Name; \
+    ARRAY_FUNCTIONS(Name, Prefix, Type, ARRAY_NO_INLINE, 0)
+
+// As ARRAY, but the first InlineCapacity elements are stored inside the array
+// itself. Small arrays must be moved with PrefixSwap rather than copied.
+#define SMALL_ARRAY(Name, Prefix, Type, InlineCapacity) \
+    typedef struct \
+    { \
+        Type* Elements; \
+        size_t Count; \
+        size_t Capacity; \
+        arena* Arena; \
+        Type Inline[InlineCapacity]; \
+    } Name; \
+    ARRAY_FUNCTIONS(Name, Prefix, Type, ARRAY_INLINE, InlineCapacity)
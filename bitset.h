@@ -0,0 +1,189 @@
+#pragma once
+
+#include <immintrin.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Bit sets of any length. Words are stored in whole 256-bit blocks with a
+// zeroed guard block on either side, so the AVX2 kernels never need to handle
+// a partial block and shifts can read one word beyond either end. Bits past
+// BitCount are always kept clear.
+typedef struct
+{
+    uint64_t* Words;
+    size_t WordCount;
+    size_t BitCount;
+} bit_set;
+
+#define BIT_SET_BLOCK_WORDS (4)
+
+static inline size_t BitSetWordCount(size_t BitCount)
+{
+    size_t BlockBits = 64 * BIT_SET_BLOCK_WORDS;
+    size_t BlockCount = (BitCount + BlockBits - 1) / BlockBits;
+    return BlockCount * BIT_SET_BLOCK_WORDS;
+}
+
+static inline uint64_t* BitSetAllocate(size_t WordCount)
+{
+    size_t Size = sizeof(uint64_t) * (WordCount + 2 * BIT_SET_BLOCK_WORDS);
+    uint64_t* Base = (uint64_t*)_mm_malloc(Size, 32);
+    memset(Base, 0, Size);
+    return Base + BIT_SET_BLOCK_WORDS;
+}
+
+static inline void InitBitSet(bit_set* Set, size_t BitCount)
+{
+    Set->WordCount = BitSetWordCount(BitCount);
+    Set->BitCount = BitCount;
+    Set->Words = BitSetAllocate(Set->WordCount);
+}
+
+static inline void FreeBitSet(bit_set* Set)
+{
+    _mm_free(Set->Words - BIT_SET_BLOCK_WORDS);
+    Set->Words = NULL;
+    Set->WordCount = 0;
+    Set->BitCount = 0;
+}
+
+static inline void BitSetClearTail(bit_set* Set)
+{
+    size_t FullWords = Set->BitCount / 64;
+    size_t Remainder = Set->BitCount % 64;
+    if(Remainder)
+    {
+        Set->Words[FullWords++] &= (1ull << Remainder) - 1;
+    }
+    memset(Set->Words + FullWords, 0, sizeof(uint64_t) * (Set->WordCount - FullWords));
+}
+
+static inline void BitSetResize(bit_set* Set, size_t BitCount)
+{
+    size_t WordCount = BitSetWordCount(BitCount);
+    if(WordCount > Set->WordCount)
+    {
+        uint64_t* Words = BitSetAllocate(WordCount);
+        memcpy(Words, Set->Words, sizeof(uint64_t) * Set->WordCount);
+        _mm_free(Set->Words - BIT_SET_BLOCK_WORDS);
+        Set->Words = Words;
+        Set->WordCount = WordCount;
+    }
+    bool Shrinking = BitCount < Set->BitCount;
+    Set->BitCount = BitCount;
+    if(Shrinking) BitSetClearTail(Set);
+}
+
+static inline void BitSetFill(bit_set* Set, bool Value)
+{
+    memset(Set->Words, Value ? 0xFF : 0, sizeof(uint64_t) * Set->WordCount);
+    if(Value) BitSetClearTail(Set);
+}
+
+static inline void BitSetSet(bit_set* Set, size_t Index)
+{
+    Set->Words[Index / 64] |= 1ull << (Index % 64);
+}
+
+static inline void BitSetClear(bit_set* Set, size_t Index)
+{
+    Set->Words[Index / 64] &= ~(1ull << (Index % 64));
+}
+
+static inline bool BitSetContains(const bit_set* Set, size_t Index)
+{
+    return (Set->Words[Index / 64] >> (Index % 64)) & 1;
+}
+
+static inline void BitSetCopy(bit_set* Dest, const bit_set* Src)
+{
+    memcpy(Dest->Words, Src->Words, sizeof(uint64_t) * Src->WordCount);
+}
+
+// The binary operations require all sets to be the same size. Dest may be one
+// of the operands.
+#define BIT_SET_BINARY_OP(Name, Expr) \
+    static inline void Name(bit_set* Dest, const bit_set* A, const bit_set* B) \
+    { \
+        for(size_t Index = 0; Index < Dest->WordCount; Index += BIT_SET_BLOCK_WORDS) \
+        { \
+            __m256i VA = _mm256_load_si256((const __m256i*)(A->Words + Index)); \
+            __m256i VB = _mm256_load_si256((const __m256i*)(B->Words + Index)); \
+            _mm256_store_si256((__m256i*)(Dest->Words + Index), Expr); \
+        } \
+    }
+
+BIT_SET_BINARY_OP(BitSetAnd, _mm256_and_si256(VA, VB))
+BIT_SET_BINARY_OP(BitSetOr, _mm256_or_si256(VA, VB))
+BIT_SET_BINARY_OP(BitSetAndNot, _mm256_andnot_si256(VB, VA)) // A & ~B
+
+// Moves every bit I to I + Shift, for Shift in [0, 64]. Dest may be Src.
+static inline void BitSetShiftLeft(bit_set* Dest, const bit_set* Src, int Shift)
+{
+    __m128i Up = _mm_cvtsi32_si128(Shift);
+    __m128i Down = _mm_cvtsi32_si128(64 - Shift);
+    for(size_t Index = Src->WordCount; Index > 0;)
+    {
+        Index -= BIT_SET_BLOCK_WORDS;
+        __m256i Curr = _mm256_load_si256((const __m256i*)(Src->Words + Index));
+        __m256i Prev = _mm256_loadu_si256((const __m256i*)(Src->Words + Index - 1));
+        __m256i Result = _mm256_or_si256(_mm256_sll_epi64(Curr, Up), _mm256_srl_epi64(Prev, Down));
+        _mm256_store_si256((__m256i*)(Dest->Words + Index), Result);
+    }
+    BitSetClearTail(Dest);
+}
+
+// Moves every bit I to I - Shift, for Shift in [0, 64]. Dest may be Src.
+static inline void BitSetShiftRight(bit_set* Dest, const bit_set* Src, int Shift)
+{
+    __m128i Down = _mm_cvtsi32_si128(Shift);
+    __m128i Up = _mm_cvtsi32_si128(64 - Shift);
+    for(size_t Index = 0; Index < Src->WordCount; Index += BIT_SET_BLOCK_WORDS)
+    {
+        __m256i Curr = _mm256_load_si256((const __m256i*)(Src->Words + Index));
+        __m256i Next = _mm256_loadu_si256((const __m256i*)(Src->Words + Index + 1));
+        __m256i Result = _mm256_or_si256(_mm256_srl_epi64(Curr, Down), _mm256_sll_epi64(Next, Up));
+        _mm256_store_si256((__m256i*)(Dest->Words + Index), Result);
+    }
+}
+
+static inline size_t BitSetCount(const bit_set* Set)
+{
+    // Count bits per nibble with a shuffle lookup, then sum bytes per lane.
+    const __m256i Lookup = _mm256_setr_epi8(
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i LowMask = _mm256_set1_epi8(0x0F);
+    const __m256i Zero = _mm256_setzero_si256();
+    __m256i Total = Zero;
+    for(size_t Index = 0; Index < Set->WordCount; Index += BIT_SET_BLOCK_WORDS)
+    {
+        __m256i V = _mm256_load_si256((const __m256i*)(Set->Words + Index));
+        __m256i Lo = _mm256_and_si256(V, LowMask);
+        __m256i Hi = _mm256_and_si256(_mm256_srli_epi16(V, 4), LowMask);
+        __m256i Counts = _mm256_add_epi8(_mm256_shuffle_epi8(Lookup, Lo), _mm256_shuffle_epi8(Lookup, Hi));
+        Total = _mm256_add_epi64(Total, _mm256_sad_epu8(Counts, Zero));
+    }
+    __m128i Sum = _mm_add_epi64(_mm256_castsi256_si128(Total), _mm256_extracti128_si256(Total, 1));
+    return (size_t)(_mm_cvtsi128_si64(Sum) + _mm_extract_epi64(Sum, 1));
+}
+
+// Returns the index of the first set bit at or after From, or BitCount if
+// there is none. Iterate over a set with:
+//
+//     for(size_t I = BitSetNext(Set, 0); I < Set->BitCount; I = BitSetNext(Set, I + 1))
+static inline size_t BitSetNext(const bit_set* Set, size_t From)
+{
+    if(From >= Set->BitCount) return Set->BitCount;
+    size_t WordIndex = From / 64;
+    uint64_t Word = Set->Words[WordIndex] & (~0ull << (From % 64));
+    size_t LastWordIndex = (Set->BitCount - 1) / 64;
+    for(;;)
+    {
+        if(Word) return 64 * WordIndex + _tzcnt_u64(Word);
+        if(++WordIndex > LastWordIndex) return Set->BitCount;
+        Word = Set->Words[WordIndex];
+    }
+}
@@ -0,0 +1,214 @@
+#!/usr/bin/env python
+
+"""
+Generates constant lookup tables for Advent of Code solutions.
+"""
+
+from pathlib import Path
+
+GEN_DIR = Path('gen')
+
+# Digits spelled out with letters, as matched by d01 part 2.
+D01_WORDS = ['one', 'two', 'three', 'four', 'five', 'six', 'seven', 'eight',
+             'nine']
+
+# Transitions into a DFA_MATCH state end a d01 scan, with the matched digit
+# in the low bits.
+DFA_MATCH = 0x80
+
+# Card ranks from weakest to strongest. The joker is rank zero, which is also
+# the rank given to any unrecognised character.
+D07_RANKS = '?23456789TJQKA'
+
+# Hand types from weakest to strongest, keyed by the size of the largest group
+# of equal ranks, then the number of single cards.
+D07_TYPES = {
+    (1, 5): 0,  # High card.
+    (2, 3): 1,  # One pair.
+    (2, 1): 2,  # Two pair.
+    (3, 2): 3,  # Three of a kind.
+    (3, 0): 4,  # Full house.
+    (4, 1): 5,  # Four of a kind.
+    (5, 0): 6,  # Five of a kind.
+}
+
+# Characters that may appear in the d10 pipe grid.
+D10_GRID_CHARS = '|-LJ7F.S'
+
+
+def format_array(values, per_line=16):
+    lines = []
+    for start in range(0, len(values), per_line):
+        chunk = values[start:start + per_line]
+        lines.append('    ' + ', '.join(str(value) for value in chunk))
+    return ',\n'.join(lines)
+
+
+def format_table(ctype, name, rows):
+    if isinstance(rows[0], list):
+        dims = f'[{len(rows)}][{len(rows[0])}]'
+        body = ',\n'.join('{\n' + format_array(row) + '\n}' for row in rows)
+        body = '\n'.join('    ' + line if line else line
+                         for line in body.split('\n'))
+    else:
+        dims = f'[{len(rows)}]'
+        body = format_array(rows)
+    return f'static const {ctype} {name}{dims} =\n{{\n{body}\n}};\n'
+
+
+def write_header(filename, description, tables):
+    contents = [
+        f'// {description}',
+        f'// Generated by codegen.py - do not edit.',
+        '',
+        '#pragma once',
+        '',
+        '#include <stdint.h>',
+        '',
+    ]
+    contents.append('\n'.join(tables))
+    path = GEN_DIR / filename
+    text = '\n'.join(contents)
+    if not path.exists() or path.read_text() != text:
+        path.write_text(text)
+
+
+def d01_digits_dfa(reverse):
+    """
+    Builds an Aho-Corasick automaton matching the digits and the spelled out
+    digits, flattened to a byte-level DFA. The DFA stops at
+    the first match, so match transitions encode the digit instead of a state.
+    Reversed patterns find the last digit when scanning backwards.
+    """
+    patterns = {str(digit): digit for digit in range(10)}
+    for digit, word in enumerate(D01_WORDS, 1):
+        patterns[word[::-1] if reverse else word] = digit
+
+    # Build the trie of patterns, then compute failure links breadth first.
+    goto = [{}]
+    output = [None]
+    for pattern, digit in patterns.items():
+        state = 0
+        for char in pattern:
+            if char not in goto[state]:
+                goto.append({})
+                output.append(None)
+                goto[state][char] = len(goto) - 1
+            state = goto[state][char]
+        output[state] = digit
+    fail = [0] * len(goto)
+    queue = list(goto[0].values())
+    while queue:
+        state = queue.pop(0)
+        for char, next_state in goto[state].items():
+            queue.append(next_state)
+            link = fail[state]
+            while link and char not in goto[link]:
+                link = fail[link]
+            # States one character deep always fail back to the root.
+            fail[next_state] = goto[link].get(char, 0) if state else 0
+            if output[next_state] is None:
+                output[next_state] = output[fail[next_state]]
+
+    # Flatten into a full transition table over all bytes, renumbering the
+    # non-matching states densely.
+    live = [state for state in range(len(goto)) if output[state] is None]
+    number = {state: index for index, state in enumerate(live)}
+    assert len(live) < DFA_MATCH
+
+    def step(state, char):
+        while state and char not in goto[state]:
+            state = fail[state]
+        return goto[state].get(char, 0)
+
+    table = []
+    for state in live:
+        row = []
+        for byte in range(256):
+            next_state = step(state, chr(byte))
+            if output[next_state] is not None:
+                row.append(DFA_MATCH | output[next_state])
+            else:
+                row.append(number[next_state])
+        table.append(row)
+    return table
+
+
+def d07_char_to_rank(use_jokers):
+    table = [0] * 256
+    for rank, char in enumerate(D07_RANKS):
+        if rank > 0:
+            table[ord(char)] = rank
+    if use_jokers:
+        table[ord('J')] = 0
+    return table
+
+
+def d07_hand_type(jokers, equal):
+    """
+    Finds the type of a hand from the cards that are jokers and from which
+    cards are equal, as described in d07.c. Bit n of equal is set when card n
+    equals card n + 1, and bit 5 + n when card n equals card n + 2, wrapping
+    around the five cards. Masks that can't come from a hand get type zero.
+    """
+    pairs = [(n, (n + 1) % 5) for n in range(5)]
+    pairs += [(n, (n + 2) % 5) for n in range(5)]
+    group = list(range(5))
+    for bit, (a, b) in enumerate(pairs):
+        if equal >> bit & 1:
+            old, new = group[b], group[a]
+            group = [new if g == old else g for g in group]
+    for bit, (a, b) in enumerate(pairs):
+        if (group[a] == group[b]) != bool(equal >> bit & 1):
+            return 0
+    is_joker = [bool(jokers >> n & 1) for n in range(5)]
+    if any(is_joker[a] != is_joker[b] for a, b in pairs
+           if group[a] == group[b]):
+        return 0
+
+    # Jokers join the largest group of other cards.
+    sizes = {}
+    for n in range(5):
+        if not is_joker[n]:
+            sizes[group[n]] = sizes.get(group[n], 0) + 1
+    counts = sorted(sizes.values(), reverse=True) or [0]
+    counts[0] += sum(is_joker)
+    return D07_TYPES[(counts[0], counts.count(1))]
+
+
+def d07_hand_types():
+    return [[d07_hand_type(jokers, equal) for equal in range(1 << 10)]
+            for jokers in range(1 << 5)]
+
+
+def d10_is_grid():
+    return [int(chr(char) in D10_GRID_CHARS) for char in range(256)]
+
+
+def d15_hash_step():
+    return [[((value + char) * 17) & 255 for char in range(256)]
+            for value in range(256)]
+
+
+def main():
+    GEN_DIR.mkdir(exist_ok=True)
+    write_header('d01_tables.h', 'Digit matching DFA tables.', [
+        f'#define DFA_MATCH (0x{DFA_MATCH:02X})\n',
+        format_table('uint8_t', 'DigitsForward', d01_digits_dfa(False)),
+        format_table('uint8_t', 'DigitsReverse', d01_digits_dfa(True)),
+    ])
+    write_header('d07_tables.h', 'Card rank and hand type lookup tables.', [
+        format_table('uint8_t', 'CharToRank',
+                     [d07_char_to_rank(False), d07_char_to_rank(True)]),
+        format_table('uint8_t', 'HandTypes', d07_hand_types()),
+    ])
+    write_header('d10_tables.h', 'Pipe grid character lookup table.', [
+        format_table('uint8_t', 'IsGrid', d10_is_grid()),
+    ])
+    write_header('d15_tables.h', 'HASH algorithm lookup table.', [
+        format_table('uint8_t', 'HashStep', d15_hash_step()),
+    ])
+
+
+if __name__ == '__main__':
+    main()
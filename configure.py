@@ -4,11 +4,15 @@
 Configures ninja files for building Advent of Code solutions.
 """
 
+import codegen
 from ninja.ninja_syntax import Writer
 from pathlib import Path
 
 
 def main():
+    # Generate lookup table headers.
+    codegen.main()
+
     with open('build.ninja', 'wt') as f:
         n = Writer(f)
         n.variable('ninja_required_version', '1.11.0')
@@ -21,6 +25,10 @@ def main():
             '-std=c11',
             '-D_CRT_SECURE_NO_WARNINGS',
             '-O3',
+            '-mavx2',
+            '-mbmi',
+            '-mlzcnt',
+            '-mpopcnt',
             '-Wall',
             '-Wextra',
             '-Werror',
@@ -1,6 +1,9 @@
 #include "aoc.h"
+#include "gen/d01_tables.h"
 #include "parse.h"
 
+#include <immintrin.h>
+
 const char* DefaultInputPath = "d01.txt";
 
 #define DIGIT(Digit) \
@@ -10,76 +13,163 @@ const char* DefaultInputPath = "d01.txt";
         LastDigit = Digit; \
     } while(0);
 
-AOC_SOLVER(Part1)
+static void AddLine(int64_t* Sum, int* FirstDigit, int LastDigit)
+{
+    if(*FirstDigit >= 0) *Sum += 10 * *FirstDigit + LastDigit;
+    *FirstDigit = -1;
+}
+
+static int64_t SumPart1(const char* Input, const char* End)
 {
     int64_t Sum = 0;
     int FirstDigit = -1;
     int LastDigit = 0;
-    char C;
-    do
+
+    // Classify 32 bytes at a time into digit and newline masks. Each newline
+    // ends a line, whose first and last digits are the lowest and highest bits
+    // of the digit mask below that newline.
+    const __m256i Zero = _mm256_set1_epi8('0' - 1);
+    const __m256i Nine = _mm256_set1_epi8('9' + 1);
+    const __m256i Newline = _mm256_set1_epi8('\n');
+    for(; End - Input >= 32; Input += 32)
+    {
+        __m256i Block = _mm256_loadu_si256((const __m256i*)Input);
+        __m256i IsDigits = _mm256_and_si256(_mm256_cmpgt_epi8(Block, Zero), _mm256_cmpgt_epi8(Nine, Block));
+        uint32_t Digits = (uint32_t)_mm256_movemask_epi8(IsDigits);
+        uint32_t Newlines = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(Block, Newline));
+        while(Newlines)
+        {
+            uint32_t LineMask = _blsmsk_u32(Newlines);
+            uint32_t LineDigits = Digits & LineMask;
+            if(LineDigits)
+            {
+                if(FirstDigit < 0) FirstDigit = Input[_tzcnt_u32(LineDigits)] - '0';
+                LastDigit = Input[31 - _lzcnt_u32(LineDigits)] - '0';
+            }
+            AddLine(&Sum, &FirstDigit, LastDigit);
+            Digits &= ~LineMask;
+            Newlines = _blsr_u32(Newlines);
+        }
+        if(Digits)
+        {
+            if(FirstDigit < 0) FirstDigit = Input[_tzcnt_u32(Digits)] - '0';
+            LastDigit = Input[31 - _lzcnt_u32(Digits)] - '0';
+        }
+    }
+
+    // Handle the remaining bytes one at a time.
+    for(; Input < End; Input++)
     {
-        C = *Input++;
+        char C = *Input;
         if(IsDigit(C))
         {
             DIGIT(C - '0');
         }
-        if(C == '\n' || C == '\0')
+        else if(C == '\n')
         {
-            Sum += 10 * FirstDigit + LastDigit;
-            FirstDigit = -1;
+            AddLine(&Sum, &FirstDigit, LastDigit);
         }
-    } while(C != '\0');
+    }
+    AddLine(&Sum, &FirstDigit, LastDigit);
     return Sum;
 }
 
-#define STRING_DIGIT(Letters, Digit) \
-    if(!strncmp(Letters, Input, sizeof(Letters) - 1)) \
-    { \
-        DIGIT(Digit); \
-        continue; \
+// Runs a digit matching DFA over Count bytes from Input, Step bytes apart,
+// until it finds a digit. Returns -1 if there are none.
+static int MatchDigit(const uint8_t (*Dfa)[256], const char* Input, ptrdiff_t Count, ptrdiff_t Step)
+{
+    uint8_t State = 0;
+    for(ptrdiff_t Index = 0; Index < Count; Index++)
+    {
+        State = Dfa[State][(uint8_t)Input[Index * Step]];
+        if(State & DFA_MATCH) return State & ~DFA_MATCH;
     }
+    return -1;
+}
 
-AOC_SOLVER(Part2)
+static int64_t SumPart2(const char* Input, const char* End)
 {
+    // Match each line from both ends, so only its first and last digits are
+    // visited. Spelled out digits may overlap, which the DFAs account for.
     int64_t Sum = 0;
-    int FirstDigit = -1;
-    int LastDigit = 0;
-    char C;
-    do
+    while(Input < End)
     {
-        C = *Input++;
-        switch(C)
+        const char* LineEnd = (const char*)memchr(Input, '\n', End - Input);
+        if(!LineEnd) LineEnd = End;
+        ptrdiff_t Length = LineEnd - Input;
+        int FirstDigit = MatchDigit(DigitsForward, Input, Length, 1);
+        if(FirstDigit >= 0)
         {
-        case '0': case '1': case '2': case '3': case '4':
-        case '5': case '6': case '7': case '8': case '9':
-            DIGIT(C - '0');
-            break;
-        case 'e':
-            STRING_DIGIT("ight", 8);
-            break;
-        case 'f':
-            STRING_DIGIT("ive", 5);
-            STRING_DIGIT("our", 4);
-            break;
-        case 'n':
-            STRING_DIGIT("ine", 9);
-            break;
-        case 'o':
-            STRING_DIGIT("ne", 1);
-            break;
-        case 's':
-            STRING_DIGIT("even", 7);
-            STRING_DIGIT("ix", 6);
-            break;
-        case 't':
-            STRING_DIGIT("hree", 3);
-            STRING_DIGIT("wo", 2);
-            break;
-        case '\n': case '\0':
+            int LastDigit = MatchDigit(DigitsReverse, LineEnd - 1, Length, -1);
             Sum += 10 * FirstDigit + LastDigit;
-            FirstDigit = -1;
-            break;
         }
-    } while(C != '\0');
+        Input = LineEnd + 1;
+    }
+    return Sum;
+}
+
+// Lines are independent, so the input is split into chunks of whole lines that
+// are summed on separate threads.
+typedef int64_t sum_fn(const char* Input, const char* End);
+
+typedef struct
+{
+    sum_fn* SumFn;
+    const char* Input;
+    size_t Length;
+    int64_t Sums[AOC_MAX_THREADS];
+} work;
+
+// Chunks start on the first line beginning at or after an even split.
+static const char* ChunkStart(work* Work, int ChunkIndex, int ChunkCount)
+{
+    if(ChunkIndex == 0) return Work->Input;
+    const char* End = Work->Input + Work->Length;
+    const char* At = Work->Input + Work->Length * ChunkIndex / ChunkCount;
+    if(At == Work->Input) return At;
+    const char* Newline = (const char*)memchr(At - 1, '\n', End - At + 1);
+    return Newline ? Newline + 1 : End;
+}
+
+static void SumChunk(void* User, int ThreadIndex, int ThreadCount)
+{
+    work* Work = (work*)User;
+    const char* Start = ChunkStart(Work, ThreadIndex, ThreadCount);
+    const char* End = ChunkStart(Work, ThreadIndex + 1, ThreadCount);
+    Work->Sums[ThreadIndex] = Work->SumFn(Start, End);
+}
+
+static int64_t Solve(const char* Input, sum_fn* SumFn)
+{
+    work Work;
+    Work.SumFn = SumFn;
+    Work.Input = Input;
+    Work.Length = strlen(Input);
+
+    // Only use as many threads as there are sizeable chunks, so small inputs
+    // aren't dominated by thread startup.
+    size_t MinChunkLength = 1 << 16;
+    int ThreadCount = AocThreadCount();
+    if(Work.Length / MinChunkLength < ThreadCount)
+    {
+        ThreadCount = (int)(Work.Length / MinChunkLength) + 1;
+    }
+    AocRunThreads(SumChunk, &Work, ThreadCount);
+
+    int64_t Sum = 0;
+    for(int Index = 0; Index < ThreadCount; Index++)
+    {
+        Sum = AocAdd(Sum, Work.Sums[Index]);
+    }
     return Sum;
 }
+
+AOC_SOLVER(Part1)
+{
+    return Solve(Input, SumPart1);
+}
+
+AOC_SOLVER(Part2)
+{
+    return Solve(Input, SumPart2);
+}
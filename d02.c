@@ -1,98 +1,496 @@
 #include "aoc.h"
+#include "array.h"
 #include "parse.h"
 
+#include <immintrin.h>
+
 const char* DefaultInputPath = "d02.txt";
 
-AOC_SOLVER(Part1)
+// The largest number of cubes of each color shown in each game, stored as
+// columns. Columns are padded with zeros to a whole number of vectors.
+typedef struct
+{
+    int32_t* Ids;
+    int32_t* Red;
+    int32_t* Green;
+    int32_t* Blue;
+    aoc_index Count;
+    aoc_index Capacity;
+} games;
+
+#define GAMES_LANES (8)
+
+static void GamesReserve(games* Games, aoc_index Capacity)
+{
+    Capacity = (Capacity + GAMES_LANES - 1) / GAMES_LANES * GAMES_LANES;
+    if(Capacity <= Games->Capacity) return;
+    int32_t** Columns[] = {&Games->Ids, &Games->Red, &Games->Green, &Games->Blue};
+    for(int Index = 0; Index < 4; Index++)
+    {
+        int32_t* Column = (int32_t*)realloc(*Columns[Index], sizeof(int32_t) * Capacity);
+        memset(Column + Games->Capacity, 0, sizeof(int32_t) * (Capacity - Games->Capacity));
+        *Columns[Index] = Column;
+    }
+    Games->Capacity = Capacity;
+}
+
+static void InitGames(games* Games, aoc_index Capacity)
+{
+    memset(Games, 0, sizeof(games));
+    GamesReserve(Games, Capacity);
+}
+
+static void FreeGames(games* Games)
+{
+    free(Games->Ids);
+    free(Games->Red);
+    free(Games->Green);
+    free(Games->Blue);
+}
+
+static void GamesAdd(games* Games, int32_t Id)
+{
+    if(Games->Count == Games->Capacity)
+    {
+        GamesReserve(Games, Games->Capacity * 2);
+    }
+    Games->Ids[Games->Count++] = Id;
+}
+
+static void Max(int32_t* Value, int32_t Candidate)
+{
+    if(Candidate > *Value) *Value = Candidate;
+}
+
+// Parses the number starting at Input. A number followed by a colon is a game
+// id, otherwise it is followed by a space and the color of the cubes.
+static void ParseNumber(games* Games, const char* Input)
+{
+    int32_t Value = 0;
+    while(IsDigit(*Input)) Value = 10 * Value + *Input++ - '0';
+    if(*Input == ':')
+    {
+        GamesAdd(Games, Value);
+        return;
+    }
+    aoc_index Game = Games->Count - 1;
+    switch(Input[1])
+    {
+    case 'r': Max(&Games->Red[Game], Value); break;
+    case 'g': Max(&Games->Green[Game], Value); break;
+    case 'b': Max(&Games->Blue[Game], Value); break;
+    }
+}
+
+// Parses the games, which may be followed by lines of bags to check them
+// against. Returns the start of the bags.
+static const char* ParseGames(games* Games, const char* Input)
+{
+    // Every number in the games is either a game id or a count of cubes, so
+    // only the starts of numbers need visiting. Find them 32 bytes at a time
+    // from a mask of digits, where a digit with no digit before it starts a
+    // number.
+    // The games never contain a capital B, so the first one starts the bags.
+    size_t Length = strlen(Input);
+    InitGames(Games, Length / 64 + 1);
+    const char* At = Input;
+    const char* End = Input + Length;
+    const __m256i Zero = _mm256_set1_epi8('0' - 1);
+    const __m256i Nine = _mm256_set1_epi8('9' + 1);
+    const __m256i BagStart = _mm256_set1_epi8('B');
+    uint32_t Carry = 0;
+    for(; End - At >= 32; At += 32)
+    {
+        __m256i Block = _mm256_loadu_si256((const __m256i*)At);
+        __m256i IsDigits = _mm256_and_si256(_mm256_cmpgt_epi8(Block, Zero), _mm256_cmpgt_epi8(Nine, Block));
+        uint32_t Digits = (uint32_t)_mm256_movemask_epi8(IsDigits);
+        uint32_t Bags = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(Block, BagStart));
+        uint32_t Starts = Digits & ~((Digits << 1) | Carry);
+        if(Bags) Starts &= _blsmsk_u32(Bags) >> 1;
+        Carry = Digits >> 31;
+        while(Starts)
+        {
+            ParseNumber(Games, At + _tzcnt_u32(Starts));
+            Starts = _blsr_u32(Starts);
+        }
+        if(Bags) return At + _tzcnt_u32(Bags);
+    }
+    for(; At < End && *At != 'B'; At++)
+    {
+        if(IsDigit(*At) && !Carry) ParseNumber(Games, At);
+        Carry = IsDigit(*At);
+    }
+    return At;
+}
+
+// Adds each 32-bit lane to a pair of 64-bit accumulators.
+static void AddWide(__m256i* Lo, __m256i* Hi, __m256i Values)
+{
+    *Lo = _mm256_add_epi64(*Lo, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(Values)));
+    *Hi = _mm256_add_epi64(*Hi, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(Values, 1)));
+}
+
+static int64_t SumWide(__m256i Lo, __m256i Hi)
+{
+    __m256i Sum = _mm256_add_epi64(Lo, Hi);
+    __m128i Half = _mm_add_epi64(_mm256_castsi256_si128(Sum), _mm256_extracti128_si256(Sum, 1));
+    return _mm_cvtsi128_si64(Half) + _mm_extract_epi64(Half, 1);
+}
+
+static __m256i Load(const int32_t* Column, aoc_index Index)
+{
+    return _mm256_loadu_si256((const __m256i*)(Column + Index));
+}
+
+// The cubes in a bag, which limit the games that are possible.
+typedef struct
+{
+    int32_t Red;
+    int32_t Green;
+    int32_t Blue;
+} bag;
+
+ARRAY(bag_array, BagArray, bag)
+
+// Parses lines of "Bag: R red, G green, B blue", with colors in any order.
+static void ParseBags(bag_array* Bags, const char* Input)
+{
+    while(*Input == 'B')
+    {
+        bag Bag = {0};
+        while(*Input != '\n' && *Input != '\0')
+        {
+            if(!IsDigit(*Input))
+            {
+                Input++;
+                continue;
+            }
+            int32_t Value = 0;
+            while(IsDigit(*Input)) Value = 10 * Value + *Input++ - '0';
+            switch(Input[1])
+            {
+            case 'r': Bag.Red = Value; break;
+            case 'g': Bag.Green = Value; break;
+            case 'b': Bag.Blue = Value; break;
+            }
+        }
+        BagArrayAdd(Bags, Bag);
+        Input = SkipPastNewline(Input);
+    }
+}
+
+// Sums the ids of the games that never show more cubes than are in the bag.
+// Padding games have an id of zero, so they add nothing.
+static int64_t ScanPossibleIds(games* Games, bag Bag)
+{
+    const __m256i MaxRed = _mm256_set1_epi32(Bag.Red);
+    const __m256i MaxGreen = _mm256_set1_epi32(Bag.Green);
+    const __m256i MaxBlue = _mm256_set1_epi32(Bag.Blue);
+    __m256i Lo = _mm256_setzero_si256();
+    __m256i Hi = _mm256_setzero_si256();
+    for(aoc_index Index = 0; Index < Games->Count; Index += GAMES_LANES)
+    {
+        __m256i Impossible = _mm256_or_si256(
+            _mm256_or_si256(
+                _mm256_cmpgt_epi32(Load(Games->Red, Index), MaxRed),
+                _mm256_cmpgt_epi32(Load(Games->Green, Index), MaxGreen)),
+            _mm256_cmpgt_epi32(Load(Games->Blue, Index), MaxBlue));
+        AddWide(&Lo, &Hi, _mm256_andnot_si256(Impossible, Load(Games->Ids, Index)));
+    }
+    return SumWide(Lo, Hi);
+}
+
+// The distinct values in a column, in ascending order.
+typedef struct
+{
+    int32_t* Values;
+    aoc_index Count;
+} axis;
+
+static int CompareInt32(const void* A, const void* B)
+{
+    int32_t ValueA = *(const int32_t*)A;
+    int32_t ValueB = *(const int32_t*)B;
+    return (ValueA > ValueB) - (ValueA < ValueB);
+}
+
+static void InitAxis(axis* Axis, const int32_t* Column, aoc_index Count)
+{
+    Axis->Values = (int32_t*)malloc(sizeof(int32_t) * (Count + 1));
+    memcpy(Axis->Values, Column, sizeof(int32_t) * Count);
+    qsort(Axis->Values, Count, sizeof(int32_t), CompareInt32);
+    Axis->Count = 0;
+    for(aoc_index Index = 0; Index < Count; Index++)
+    {
+        if(Axis->Count == 0 || Axis->Values[Axis->Count - 1] != Axis->Values[Index])
+        {
+            Axis->Values[Axis->Count++] = Axis->Values[Index];
+        }
+    }
+}
+
+static void FreeAxis(axis* Axis)
 {
+    free(Axis->Values);
+}
+
+// Returns the number of sorted values that are less than Limit.
+static aoc_index CountLess(const int32_t* Values, aoc_index Count, int32_t Limit)
+{
+    aoc_index Lo = 0;
+    aoc_index Hi = Count;
+    while(Lo < Hi)
+    {
+        aoc_index Mid = Lo + (Hi - Lo) / 2;
+        if(Values[Mid] < Limit) Lo = Mid + 1;
+        else Hi = Mid;
+    }
+    return Lo;
+}
+
+// Returns the number of sorted values that are at most Limit.
+static aoc_index CountAtMost(const int32_t* Values, aoc_index Count, int32_t Limit)
+{
+    return Limit == INT32_MAX ? Count : CountLess(Values, Count, Limit + 1);
+}
+
+// Sorts items by a count, keeping their positions.
+typedef struct
+{
+    int32_t Count;
+    aoc_index Index;
+} count_order;
+
+static int CompareCountOrders(const void* A, const void* B)
+{
+    const count_order* OrderA = (const count_order*)A;
+    const count_order* OrderB = (const count_order*)B;
+    return (OrderA->Count > OrderB->Count) - (OrderA->Count < OrderB->Count);
+}
+
+static count_order* SortByCount(const int32_t* Counts, aoc_index Count)
+{
+    count_order* Orders = (count_order*)malloc(sizeof(count_order) * (Count + 1));
+    for(aoc_index Index = 0; Index < Count; Index++)
+    {
+        Orders[Index] = (count_order){.Count = Counts[Index], .Index = Index};
+    }
+    qsort(Orders, Count, sizeof(count_order), CompareCountOrders);
+    return Orders;
+}
+
+// An index over a set of games, built once and then used to answer batches of
+// bags. A batch is answered by sweeping through the bags and games in order
+// of red, adding each game with at most the bag's red cubes to a two
+// dimensional Fenwick tree over green and blue, then reading the sum of ids
+// of the games added with at most the bag's green and blue cubes.
+//
+// Node J of the tree covers the games whose green count is among the
+// (J - LowBit(J), J] smallest distinct green counts. It holds the sorted blue
+// counts of those games, and a Fenwick tree of its own over them, so the index
+// takes O(N log N) space and each game or bag is added or read in
+// O(log^2 N) time.
+typedef struct
+{
+    games* Games;
+    count_order* ByRed;
+    axis Green;
+    aoc_index* NodeStarts;
+    int32_t* NodeBlues;
+    int64_t* NodeSums;
+} game_index;
+
+static aoc_index LowBit(aoc_index Value)
+{
+    return Value & -Value;
+}
+
+static void InitGameIndex(game_index* GameIndex, games* Games)
+{
+    GameIndex->Games = Games;
+    GameIndex->ByRed = SortByCount(Games->Red, Games->Count);
+    InitAxis(&GameIndex->Green, Games->Green, Games->Count);
+
+    // Count the games in each node, then place their blue counts and sort
+    // them.
+    axis* Green = &GameIndex->Green;
+    aoc_index* Starts = (aoc_index*)calloc(Green->Count + 2, sizeof(aoc_index));
+    for(aoc_index Game = 0; Game < Games->Count; Game++)
+    {
+        aoc_index Rank = CountAtMost(Green->Values, Green->Count, Games->Green[Game]);
+        for(aoc_index Node = Rank; Node <= Green->Count; Node += LowBit(Node))
+        {
+            Starts[Node + 1]++;
+        }
+    }
+    for(aoc_index Node = 1; Node <= Green->Count + 1; Node++)
+    {
+        Starts[Node] += Starts[Node - 1];
+    }
+    aoc_index Size = Starts[Green->Count + 1];
+    int32_t* Blues = (int32_t*)malloc(sizeof(int32_t) * (Size + 1));
+    aoc_index* Ends = (aoc_index*)malloc(sizeof(aoc_index) * (Green->Count + 1));
+    memcpy(Ends, Starts, sizeof(aoc_index) * (Green->Count + 1));
+    for(aoc_index Game = 0; Game < Games->Count; Game++)
+    {
+        aoc_index Rank = CountAtMost(Green->Values, Green->Count, Games->Green[Game]);
+        for(aoc_index Node = Rank; Node <= Green->Count; Node += LowBit(Node))
+        {
+            Blues[Ends[Node]++] = Games->Blue[Game];
+        }
+    }
+    for(aoc_index Node = 1; Node <= Green->Count; Node++)
+    {
+        qsort(Blues + Starts[Node], Starts[Node + 1] - Starts[Node], sizeof(int32_t), CompareInt32);
+    }
+    free(Ends);
+    GameIndex->NodeStarts = Starts;
+    GameIndex->NodeBlues = Blues;
+    GameIndex->NodeSums = (int64_t*)malloc(sizeof(int64_t) * (Size + 1));
+}
+
+static void FreeGameIndex(game_index* GameIndex)
+{
+    free(GameIndex->ByRed);
+    FreeAxis(&GameIndex->Green);
+    free(GameIndex->NodeStarts);
+    free(GameIndex->NodeBlues);
+    free(GameIndex->NodeSums);
+}
+
+static void GameIndexAdd(game_index* GameIndex, aoc_index Game)
+{
+    games* Games = GameIndex->Games;
+    axis* Green = &GameIndex->Green;
+    aoc_index Rank = CountAtMost(Green->Values, Green->Count, Games->Green[Game]);
+    for(aoc_index Node = Rank; Node <= Green->Count; Node += LowBit(Node))
+    {
+        aoc_index Start = GameIndex->NodeStarts[Node];
+        aoc_index Count = GameIndex->NodeStarts[Node + 1] - Start;
+        int64_t* Sums = GameIndex->NodeSums + Start - 1;
+        aoc_index Position = CountLess(GameIndex->NodeBlues + Start, Count, Games->Blue[Game]) + 1;
+        for(; Position <= Count; Position += LowBit(Position))
+        {
+            Sums[Position] += Games->Ids[Game];
+        }
+    }
+}
+
+static int64_t GameIndexSum(game_index* GameIndex, bag Bag)
+{
+    axis* Green = &GameIndex->Green;
     int64_t Sum = 0;
-    int GameID, Cubes;
-    bool Possible;
-    char C;
-    do
+    for(aoc_index Node = CountAtMost(Green->Values, Green->Count, Bag.Green); Node > 0; Node -= LowBit(Node))
     {
-        C = *Input++;
-        switch(C)
+        aoc_index Start = GameIndex->NodeStarts[Node];
+        aoc_index Count = GameIndex->NodeStarts[Node + 1] - Start;
+        int64_t* Sums = GameIndex->NodeSums + Start - 1;
+        for(aoc_index Position = CountAtMost(GameIndex->NodeBlues + Start, Count, Bag.Blue); Position > 0; Position -= LowBit(Position))
         {
-        case 'G':
-            Input += 4;
-            GameID = atoi(Input);
-            Possible = true;
-            Input = SkipPastDigits(Input) + 2;
-            break;
-        case '0': case '1': case '2': case '3': case '4':
-        case '5': case '6': case '7': case '8': case '9':
-            Cubes = atoi(Input - 1);
-            Input = SkipPastDigits(Input) + 1;
-            break;
-        case 'r':
-            Possible &= Cubes <= 12;
-            Input += 2;
-            break;
-        case 'g':
-            Possible &= Cubes <= 13;
-            Input += 4;
-            break;
-        case 'b':
-            Possible &= Cubes <= 14;
-            Input += 3;
-            break;
-        case ',':
-            Input++;
-            break;
-        case ';':
-            Input++;
-            break;
-        case '\n':
-        case '\0':
-            if(Possible) Sum += GameID;
-            break;
+            Sum += Sums[Position];
         }
-    } while(C != '\0');
+    }
     return Sum;
 }
 
+// Answers a batch of bags, writing the sum of the ids of the possible games
+// for each. A few bags are cheaper to scan the games for than to sweep.
+static void GameIndexSumPossibleIds(game_index* GameIndex, const bag* Bags, aoc_index BagCount, int64_t* OutSums)
+{
+    games* Games = GameIndex->Games;
+    if(BagCount < 4)
+    {
+        for(aoc_index Index = 0; Index < BagCount; Index++)
+        {
+            OutSums[Index] = ScanPossibleIds(Games, Bags[Index]);
+        }
+        return;
+    }
+    memset(GameIndex->NodeSums, 0, sizeof(int64_t) * GameIndex->NodeStarts[GameIndex->Green.Count + 1]);
+    int32_t* Reds = (int32_t*)malloc(sizeof(int32_t) * (BagCount + 1));
+    for(aoc_index Index = 0; Index < BagCount; Index++)
+    {
+        Reds[Index] = Bags[Index].Red;
+    }
+    count_order* BagsByRed = SortByCount(Reds, BagCount);
+    free(Reds);
+    aoc_index Next = 0;
+    for(aoc_index Index = 0; Index < BagCount; Index++)
+    {
+        count_order Bag = BagsByRed[Index];
+        for(; Next < Games->Count && GameIndex->ByRed[Next].Count <= Bag.Count; Next++)
+        {
+            GameIndexAdd(GameIndex, GameIndex->ByRed[Next].Index);
+        }
+        OutSums[Bag.Index] = GameIndexSum(GameIndex, Bags[Bag.Index]);
+    }
+    free(BagsByRed);
+}
+
+// Part 1 checks the games against a bag of 12 red, 13 green and 14 blue cubes.
+// When the games are followed by bags of their own, each of those is checked
+// instead, and its sum is printed on a line of its own.
+AOC_SOLVER(Part1)
+{
+    games Games;
+    bag_array Bags;
+    InitBagArray(&Bags);
+    ParseBags(&Bags, ParseGames(&Games, Input));
+    int64_t Result = -1;
+    if(!Bags.Count)
+    {
+        Result = ScanPossibleIds(&Games, (bag){.Red = 12, .Green = 13, .Blue = 14});
+    }
+    else
+    {
+        int64_t* Sums = (int64_t*)malloc(sizeof(int64_t) * Bags.Count);
+        game_index GameIndex;
+        InitGameIndex(&GameIndex, &Games);
+        GameIndexSumPossibleIds(&GameIndex, Bags.Elements, (aoc_index)Bags.Count, Sums);
+        FreeGameIndex(&GameIndex);
+        for(size_t Index = 0; Index < Bags.Count; Index++)
+        {
+            printf("%lld\n", (long long)Sums[Index]);
+        }
+        free(Sums);
+    }
+    FreeBagArray(&Bags);
+    FreeGames(&Games);
+    return Result;
+}
+
 AOC_SOLVER(Part2)
 {
-    int64_t Sum = 0;
-    int Cubes, MaxRed, MaxBlue, MaxGreen;
-    char C;
-    do
+    games Games;
+    ParseGames(&Games, Input);
+
+    // Sum the power of the fewest cubes that make each game possible. Powers of
+    // counts up to 2^10 fit in 32-bit lanes. Games with larger counts are
+    // multiplied one at a time instead, with overflow checks.
+    const __m256i MaxCount = _mm256_set1_epi32(1 << 10);
+    __m256i Lo = _mm256_setzero_si256();
+    __m256i Hi = _mm256_setzero_si256();
+    int64_t LargeSum = 0;
+    for(aoc_index Index = 0; Index < Games.Count; Index += GAMES_LANES)
     {
-        C = *Input++;
-        switch(C)
+        __m256i Red = Load(Games.Red, Index);
+        __m256i Green = Load(Games.Green, Index);
+        __m256i Blue = Load(Games.Blue, Index);
+        __m256i Large = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpgt_epi32(Red, MaxCount), _mm256_cmpgt_epi32(Green, MaxCount)),
+            _mm256_cmpgt_epi32(Blue, MaxCount));
+        if(!_mm256_testz_si256(Large, Large))
         {
-        case 'G':
-            MaxRed = MaxBlue = MaxGreen = 0;
-            Input += 4;
-            Input = SkipPastDigits(Input) + 2;
-            break;
-        case '0': case '1': case '2': case '3': case '4':
-        case '5': case '6': case '7': case '8': case '9':
-            Cubes = atoi(Input - 1);
-            Input = SkipPastDigits(Input) + 1;
-            break;
-        case 'r':
-            if(Cubes > MaxRed) MaxRed = Cubes;
-            Input += 2;
-            break;
-        case 'g':
-            if(Cubes > MaxGreen) MaxGreen = Cubes;
-            Input += 4;
-            break;
-        case 'b':
-            if(Cubes > MaxBlue) MaxBlue = Cubes;
-            Input += 3;
-            break;
-        case ';':
-        case ',':
-            Input++;
-            break;
-        case '\n':
-        case '\0':
-            Sum += MaxRed * MaxGreen * MaxBlue;
-            break;
+            for(aoc_index Game = Index; Game < Index + GAMES_LANES; Game++)
+            {
+                int64_t Power = AocMul(AocMul(Games.Red[Game], Games.Green[Game]), Games.Blue[Game]);
+                LargeSum = AocAdd(LargeSum, Power);
+            }
+            continue;
         }
-    } while(C != '\0');
-    return Sum;
+        AddWide(&Lo, &Hi, _mm256_mullo_epi32(_mm256_mullo_epi32(Red, Green), Blue));
+    }
+
+    FreeGames(&Games);
+    return AocAdd(SumWide(Lo, Hi), LargeSum);
 }
@@ -1,11 +1,14 @@
 #include "aoc.h"
+#include "bitset.h"
 #include "parse.h"
 
+#include <immintrin.h>
+
 const char* DefaultInputPath = "d03.txt";
 
-static int GetInputWidth(const char* Input)
+static aoc_index GetInputWidth(const char* Input)
 {
-    int Width = 0;
+    aoc_index Width = 0;
     for(;;)
     {
         switch(*Input++)
@@ -19,124 +22,281 @@ static int GetInputWidth(const char* Input)
     }
 }
 
-static const char* ParseSchematic(const char* Input, int* OutWidth, int* OutHeight)
+// The schematic is read in place. Rows are Width cells long, but Stride bytes
+// apart to account for their line endings.
+typedef struct
+{
+    const char* Cells;
+    aoc_index Width;
+    aoc_index Stride;
+    aoc_index Height;
+} schematic;
+
+static void InitSchematic(schematic* Schematic, const char* Input)
+{
+    aoc_index Width = GetInputWidth(Input);
+    int NewlineLength = Input[Width] == '\r' ? 2 : 1;
+    Schematic->Cells = Input;
+    Schematic->Width = Width;
+    Schematic->Stride = Width + NewlineLength;
+    Schematic->Height = (aoc_index)((strlen(Input) + NewlineLength) / Schematic->Stride);
+}
+
+static const char* SchematicRow(schematic* Schematic, aoc_index Y)
+{
+    return Schematic->Cells + Y * Schematic->Stride;
+}
+
+static bool IsSymbol(char C)
 {
-    char* Schematic = (char*)malloc(strlen(Input) * 2); // Estimate.
-    int Height = 2;
-    int Width = GetInputWidth(Input) + 2;
-    int Index = 0;
-    for(int X = 0; X < Width; X++)
+    return C != '.' && !IsDigit(C);
+}
+
+// Sets a bit for each digit and symbol in a row, 32 cells at a time.
+static void ClassifyRow(const char* Row, aoc_index Width, bit_set* Digits, bit_set* Symbols)
+{
+    BitSetFill(Digits, false);
+    BitSetFill(Symbols, false);
+    const __m256i Zero = _mm256_set1_epi8('0' - 1);
+    const __m256i Nine = _mm256_set1_epi8('9' + 1);
+    const __m256i Dot = _mm256_set1_epi8('.');
+    aoc_index X = 0;
+    for(; X + 32 <= Width; X += 32)
     {
-        Schematic[Index++] = '.'; // Top padding.
+        __m256i Block = _mm256_loadu_si256((const __m256i*)(Row + X));
+        __m256i IsDigits = _mm256_and_si256(_mm256_cmpgt_epi8(Block, Zero), _mm256_cmpgt_epi8(Nine, Block));
+        __m256i IsOthers = _mm256_or_si256(IsDigits, _mm256_cmpeq_epi8(Block, Dot));
+        uint64_t DigitBits = (uint32_t)_mm256_movemask_epi8(IsDigits);
+        uint64_t SymbolBits = ~(uint32_t)_mm256_movemask_epi8(IsOthers);
+        Digits->Words[X / 64] |= DigitBits << (X % 64);
+        Symbols->Words[X / 64] |= SymbolBits << (X % 64);
     }
-    Schematic[Index++] = '.'; // Left padding.
-    char C;
-    do
-    {
-        C = *Input++;
-        switch(C)
-        {
-        case '\r':
-            break;
-        case '\0':
-            Schematic[Index++] = '.'; // Right padding.
-            Height++;
-            break;
-        case '\n':
-            Schematic[Index++] = '.'; // Right padding.
-            Height++;
-            Schematic[Index++] = '.'; // Left padding.
-            break;
-        default:
-            Schematic[Index++] = C;
-            break;
-        }
-    } while(C != '\0');
-    for(int X = 0; X < Width; X++)
+    for(; X < Width; X++)
     {
-        Schematic[Index++] = '.'; // Bottom padding.
+        if(IsDigit(Row[X])) BitSetSet(Digits, X);
+        if(IsSymbol(Row[X])) BitSetSet(Symbols, X);
     }
-    *OutWidth = Width;
-    *OutHeight = Height;
-    return Schematic;
+}
+
+static int64_t ParseNumber(const char* Input)
+{
+    int64_t Number = 0;
+    while(IsDigit(*Input)) Number = AocAdd(AocMul(Number, 10), *Input++ - '0');
+    return Number;
 }
 
 AOC_SOLVER(Part1)
 {
+    schematic Schematic;
+    InitSchematic(&Schematic, Input);
+    aoc_index Width = Schematic.Width;
+
+    // Keep masks of the symbols on the rows above, on and below the current
+    // row, and of the digits on the current and next rows, rotating them as
+    // the rows advance.
+    bit_set Symbols[3], Digits[2], Near, Spread;
+    for(int Index = 0; Index < 3; Index++)
+    {
+        InitBitSet(&Symbols[Index], Width);
+    }
+    for(int Index = 0; Index < 2; Index++)
+    {
+        InitBitSet(&Digits[Index], Width);
+    }
+    InitBitSet(&Near, Width);
+    InitBitSet(&Spread, Width);
+    bit_set* Above = &Symbols[0];
+    bit_set* Row = &Symbols[1];
+    bit_set* Below = &Symbols[2];
+    bit_set* RowDigits = &Digits[0];
+    bit_set* BelowDigits = &Digits[1];
+    ClassifyRow(SchematicRow(&Schematic, 0), Width, RowDigits, Row);
+
     int64_t Sum = 0;
-    int Width, Height;
-    const char* Schematic = ParseSchematic(Input, &Width, &Height);
-    int Size = Width * Height;
-    for(int Index = 0; Index < Size; Index++)
+    for(aoc_index Y = 0; Y < Schematic.Height; Y++)
     {
-        if(!IsDigit(Schematic[Index])) continue;
-        int Number = atoi(Schematic + Index);
-        int LeftIndex = Index - 1;
-        do { Index++; } while(IsDigit(Schematic[Index]));
-        if(Schematic[LeftIndex] != '.') goto PartNumber;
-        if(Schematic[Index] != '.') goto PartNumber;
-        for(int TestIndex = LeftIndex - Width; TestIndex <= Index - Width; TestIndex++)
+        if(Y + 1 < Schematic.Height)
+        {
+            ClassifyRow(SchematicRow(&Schematic, Y + 1), Width, BelowDigits, Below);
+        }
+        else
+        {
+            BitSetFill(Below, false);
+        }
+
+        // Cells next to a symbol are the window's symbols dilated sideways.
+        BitSetOr(&Near, Above, Row);
+        BitSetOr(&Near, &Near, Below);
+        BitSetShiftLeft(&Spread, &Near, 1);
+        BitSetOr(&Spread, &Spread, &Near);
+        BitSetShiftRight(&Near, &Near, 1);
+        BitSetOr(&Near, &Near, &Spread);
+
+        // Mark digits next to a symbol, then spread the marks leftwards until
+        // they reach the start of their number.
+        BitSetAnd(&Near, &Near, RowDigits);
+        for(;;)
         {
-            if(Schematic[TestIndex] != '.') goto PartNumber;
+            BitSetShiftRight(&Spread, &Near, 1);
+            BitSetAnd(&Spread, &Spread, RowDigits);
+            BitSetAndNot(&Spread, &Spread, &Near);
+            if(BitSetNext(&Spread, 0) == Spread.BitCount) break;
+            BitSetOr(&Near, &Near, &Spread);
         }
-        for(int TestIndex = LeftIndex + Width; TestIndex <= Index + Width; TestIndex++)
+
+        // The first marked digit of each number is its start.
+        const char* Cells = SchematicRow(&Schematic, Y);
+        for(size_t X = BitSetNext(&Near, 0); X < Near.BitCount; X = BitSetNext(&Near, X + 1))
         {
-            if(Schematic[TestIndex] != '.') goto PartNumber;
+            Sum = AocAdd(Sum, ParseNumber(Cells + X));
+            while(X + 1 < Width && IsDigit(Cells[X + 1])) X++;
         }
-        continue;
-    PartNumber:
-        Sum += Number;
+
+        bit_set* Temp = Above;
+        Above = Row;
+        Row = Below;
+        Below = Temp;
+        Temp = RowDigits;
+        RowDigits = BelowDigits;
+        BelowDigits = Temp;
     }
-    free((void*)Schematic);
+
+    for(int Index = 0; Index < 3; Index++)
+    {
+        FreeBitSet(&Symbols[Index]);
+    }
+    for(int Index = 0; Index < 2; Index++)
+    {
+        FreeBitSet(&Digits[Index]);
+    }
+    FreeBitSet(&Near);
+    FreeBitSet(&Spread);
     return Sum;
 }
 
-static int AddGearAdj(int* Numbers, int Number, int Count)
+// Part 2 labels every digit with the column its number starts in, plus one so
+// that zero means no number. Rows are assumed to be narrower than 2^31 cells,
+// so labels take 32 bits. Labels depend only on their own row, so both the
+// labeling and the gear search are split into bands of rows that are
+// processed on separate threads.
+typedef struct
+{
+    schematic* Schematic;
+    int32_t* Labels;
+    int64_t Sums[AOC_MAX_THREADS];
+} gear_work;
+
+static void GetBand(gear_work* Work, int ThreadIndex, int ThreadCount, aoc_index* OutStartY, aoc_index* OutEndY)
+{
+    int64_t Height = Work->Schematic->Height;
+    *OutStartY = (aoc_index)(Height * ThreadIndex / ThreadCount);
+    *OutEndY = (aoc_index)(Height * (ThreadIndex + 1) / ThreadCount);
+}
+
+static void LabelBand(void* User, int ThreadIndex, int ThreadCount)
+{
+    gear_work* Work = (gear_work*)User;
+    schematic* Schematic = Work->Schematic;
+    aoc_index Width = Schematic->Width;
+    aoc_index StartY, EndY;
+    GetBand(Work, ThreadIndex, ThreadCount, &StartY, &EndY);
+    for(aoc_index Y = StartY; Y < EndY; Y++)
+    {
+        const char* Cells = SchematicRow(Schematic, Y);
+        int32_t* Labels = Work->Labels + Y * Width;
+        int32_t Label = 0;
+        for(aoc_index X = 0; X < Width; X++)
+        {
+            if(!IsDigit(Cells[X])) Label = 0;
+            else if(!Label) Label = (int32_t)X + 1;
+            Labels[X] = Label;
+        }
+    }
+}
+
+// Adds the start of the number labeled at X in a row, unless it's already
+// adjacent.
+static int AddGearAdj(const char** Adj, int Count, const char* Cells, const int32_t* Labels, aoc_index X, aoc_index Width)
 {
-    if(Number == 0 || Count > 2) return Count;
+    if(X < 0 || X >= Width) return Count;
+    int32_t Label = Labels[X];
+    if(!Label) return Count;
+    const char* Start = Cells + Label - 1;
     for(int Index = 0; Index < Count; Index++)
     {
-        if(Numbers[Index] == Number) return Count;
+        if(Adj[Index] == Start) return Count;
     }
-    Numbers[Count++] = Number;
-    return Count;
+    Adj[Count] = Start;
+    return Count + 1;
 }
 
-AOC_SOLVER(Part2)
+// Finds the numbers in a row next to X. A digit directly above or below is
+// part of the only number there, otherwise one number may touch each corner.
+static int AddGearAdjRow(const char** Adj, int Count, const char* Cells, const int32_t* Labels, aoc_index X, aoc_index Width)
 {
+    if(Labels[X]) return AddGearAdj(Adj, Count, Cells, Labels, X, Width);
+    Count = AddGearAdj(Adj, Count, Cells, Labels, X - 1, Width);
+    return AddGearAdj(Adj, Count, Cells, Labels, X + 1, Width);
+}
+
+static void SumGearBand(void* User, int ThreadIndex, int ThreadCount)
+{
+    gear_work* Work = (gear_work*)User;
+    schematic* Schematic = Work->Schematic;
+    aoc_index Width = Schematic->Width;
+    aoc_index StartY, EndY;
+    GetBand(Work, ThreadIndex, ThreadCount, &StartY, &EndY);
     int64_t Sum = 0;
-    int Width, Height;
-    const char* Schematic = ParseSchematic(Input, &Width, &Height);
-    int Size = Width * Height;
-    int* Numbers = (int*)malloc(sizeof(int) * Size);
-    for(int Index = 0; Index < Size; Index++)
+    for(aoc_index Y = StartY; Y < EndY; Y++)
     {
-        if(IsDigit(Schematic[Index]))
+        const char* Cells = SchematicRow(Schematic, Y);
+        const int32_t* Labels = Work->Labels + Y * Width;
+        for(aoc_index X = 0; X < Width; X++)
         {
-            int Number = atoi(Schematic + Index);
-            do
+            if(Cells[X] != '*') continue;
+            const char* Adj[6];
+            int AdjCount = 0;
+            if(Y > 0)
             {
-                Numbers[Index++] = Number;
-            } while(IsDigit(Schematic[Index]));
+                AdjCount = AddGearAdjRow(Adj, AdjCount, Cells - Schematic->Stride, Labels - Width, X, Width);
+            }
+            AdjCount = AddGearAdjRow(Adj, AdjCount, Cells, Labels, X, Width);
+            if(Y + 1 < Schematic->Height)
+            {
+                AdjCount = AddGearAdjRow(Adj, AdjCount, Cells + Schematic->Stride, Labels + Width, X, Width);
+            }
+            if(AdjCount != 2) continue;
+            int64_t First = ParseNumber(Adj[0]);
+            int64_t Second = ParseNumber(Adj[1]);
+            Sum = AocAdd(Sum, AocMul(First, Second));
         }
-        Numbers[Index] = 0;
     }
-    for(int Index = 0; Index < Size; Index++)
+    Work->Sums[ThreadIndex] = Sum;
+}
+
+AOC_SOLVER(Part2)
+{
+    schematic Schematic;
+    InitSchematic(&Schematic, Input);
+    gear_work Work;
+    Work.Schematic = &Schematic;
+    Work.Labels = (int32_t*)malloc(sizeof(int32_t) * Schematic.Width * Schematic.Height);
+
+    // Give each thread a sizeable band, so small inputs run on one thread.
+    int MinBandHeight = 1024;
+    int ThreadCount = AocThreadCount();
+    if(Schematic.Height / MinBandHeight < ThreadCount)
+    {
+        ThreadCount = Schematic.Height / MinBandHeight + 1;
+    }
+    AocRunThreads(LabelBand, &Work, ThreadCount);
+    AocRunThreads(SumGearBand, &Work, ThreadCount);
+
+    int64_t Sum = 0;
+    for(int Index = 0; Index < ThreadCount; Index++)
     {
-        if(Schematic[Index] != '*') continue;
-        int AdjNumbers[3];
-        int AdjCount = 0;
-        AdjCount = AddGearAdj(AdjNumbers, Numbers[Index - Width - 1], AdjCount);
-        AdjCount = AddGearAdj(AdjNumbers, Numbers[Index - Width], AdjCount);
-        AdjCount = AddGearAdj(AdjNumbers, Numbers[Index - Width + 1], AdjCount);
-        AdjCount = AddGearAdj(AdjNumbers, Numbers[Index - 1], AdjCount);
-        AdjCount = AddGearAdj(AdjNumbers, Numbers[Index + 1], AdjCount);
-        AdjCount = AddGearAdj(AdjNumbers, Numbers[Index + Width - 1], AdjCount);
-        AdjCount = AddGearAdj(AdjNumbers, Numbers[Index + Width], AdjCount);
-        AdjCount = AddGearAdj(AdjNumbers, Numbers[Index + Width + 1], AdjCount);
-        if(AdjCount == 2) Sum += AdjNumbers[0] * AdjNumbers[1];
+        Sum = AocAdd(Sum, Work.Sums[Index]);
     }
-    free(Numbers);
-    free((void*)Schematic);
+    free(Work.Labels);
     return Sum;
 }
@@ -1,12 +1,123 @@
 #include "aoc.h"
+#include "array.h"
+#include "bitset.h"
 #include "parse.h"
 
+#include <immintrin.h>
+
 const char* DefaultInputPath = "d04.txt";
 
-static const char* Next(const char* Input, int* OutMatches)
+static const char* SkipPastHeader(const char* Input)
+{
+    Input += 4; // Skip "Card".
+    while(*Input == ' ') Input++;
+    while(IsDigit(*Input)) Input++;
+    return Input + 1;
+}
+
+static const char* FindLineEnd(const char* Input)
+{
+    while(*Input != '\n' && *Input != '\r' && *Input != '\0') Input++;
+    return Input;
+}
+
+ARRAY(number_array, NumberArray, uint64_t)
+
+// Winning numbers below WINNING_LIMIT are kept in a bit set, which grows only
+// as far as the largest of them. Larger numbers are rare, so they're kept in a
+// list that is sorted once the card's winning numbers are read. The small
+// numbers are listed too, so only their bits are cleared for the next card.
+#define WINNING_LIMIT (1 << 16)
+
+typedef struct
+{
+    bit_set Small;
+    number_array Added;
+    number_array Large;
+} winning_set;
+
+static void InitWinningSet(winning_set* Set)
+{
+    InitBitSet(&Set->Small, 128);
+    InitNumberArray(&Set->Added);
+    InitNumberArray(&Set->Large);
+}
+
+static void FreeWinningSet(winning_set* Set)
+{
+    FreeBitSet(&Set->Small);
+    FreeNumberArray(&Set->Added);
+    FreeNumberArray(&Set->Large);
+}
+
+static void WinningSetClear(winning_set* Set)
+{
+    for(size_t Index = 0; Index < Set->Added.Count; Index++)
+    {
+        BitSetClear(&Set->Small, Set->Added.Elements[Index]);
+    }
+    NumberArrayReset(&Set->Added);
+    NumberArrayReset(&Set->Large);
+}
+
+static void WinningSetAdd(winning_set* Set, uint64_t Number)
 {
-    uint64_t Lo = 0, Hi = 0;
-    int Number, Matches = 0;
+    if(Number >= WINNING_LIMIT)
+    {
+        NumberArrayAdd(&Set->Large, Number);
+        return;
+    }
+    if(Number >= Set->Small.BitCount) BitSetResize(&Set->Small, Number + 1);
+    BitSetSet(&Set->Small, Number);
+    NumberArrayAdd(&Set->Added, Number);
+}
+
+static int CompareNumbers(const void* A, const void* B)
+{
+    uint64_t NumberA = *(const uint64_t*)A;
+    uint64_t NumberB = *(const uint64_t*)B;
+    return (NumberA > NumberB) - (NumberA < NumberB);
+}
+
+static void WinningSetSortLarge(winning_set* Set)
+{
+    qsort(Set->Large.Elements, Set->Large.Count, sizeof(uint64_t), CompareNumbers);
+}
+
+// Removes a number from the set, returning whether it was there. Own numbers
+// are removed as they match, so a repeated number only matches once.
+static bool WinningSetRemove(winning_set* Set, uint64_t Number)
+{
+    if(Number < Set->Small.BitCount)
+    {
+        bool Contains = BitSetContains(&Set->Small, Number);
+        BitSetClear(&Set->Small, Number);
+        return Contains;
+    }
+    if(Number < WINNING_LIMIT || !Set->Large.Count) return false;
+    uint64_t* Found = (uint64_t*)bsearch(&Number, Set->Large.Elements, Set->Large.Count, sizeof(uint64_t), CompareNumbers);
+    if(!Found) return false;
+
+    // Remove every copy of a repeated winning number.
+    uint64_t* Begin = Found;
+    uint64_t* End = Found + 1;
+    uint64_t* Elements = Set->Large.Elements;
+    uint64_t* Last = Elements + Set->Large.Count;
+    while(Begin > Elements && Begin[-1] == Number) Begin--;
+    while(End < Last && *End == Number) End++;
+    memmove(Begin, End, sizeof(uint64_t) * (Last - End));
+    Set->Large.Count -= End - Begin;
+    return true;
+}
+
+// Parses a card of any format, one number at a time. Matches are the numbers
+// on both sides, counted once each however often they're repeated, as they
+// are when cards are parsed into 128-bit sets.
+static const char* Next(const char* Input, winning_set* WinningNumbers, int* OutMatches)
+{
+    WinningSetClear(WinningNumbers);
+    uint64_t Number;
+    int Matches = 0;
     bool Winning = true;
     char C;
     for(;;)
@@ -15,42 +126,23 @@ static const char* Next(const char* Input, int* OutMatches)
         switch(C)
         {
         case 'C':
-            Input += 4;
-            while(*Input == ' ') Input++;
-            while(IsDigit(*Input)) Input++;
-            Input += 2;
+            Input = SkipPastHeader(Input - 1) + 1;
             break;
         case '0': case '1': case '2': case '3': case '4':
         case '5': case '6': case '7': case '8': case '9':
-            Number = atoi(Input - 1);
+            Number = strtoull(Input - 1, NULL, 10);
             while(IsDigit(*Input)) Input++;
             if(Winning)
             {
-                if(Number >= 64)
-                {
-                    Hi |= 1llu << (Number - 64);
-                }
-                else
-                {
-                    Lo |= 1llu << Number;
-                }
+                WinningSetAdd(WinningNumbers, Number);
             }
             else
             {
-                uint64_t Set;
-                if(Number >= 64)
-                {
-                    Set = Hi;
-                    Number -= 64;
-                }
-                else
-                {
-                    Set = Lo;
-                }
-                if(Set & (1llu << Number)) Matches++;
+                Matches += WinningSetRemove(WinningNumbers, Number);
             }
             break;
         case '|':
+            WinningSetSortLarge(WinningNumbers);
             Winning = false;
             Input++;
             break;
@@ -64,46 +156,188 @@ static const char* Next(const char* Input, int* OutMatches)
     }
 }
 
+// Converts Count fields of a space followed by a two digit number, with the
+// tens padded by a space when zero, into a 128-bit set, four fields at a
+// time. Returns false if the fields don't have this format.
+static bool FieldsToSet(const char* Input, int Count, uint64_t* OutSet)
+{
+    const __m128i Gather = _mm_setr_epi8(1, 2, 4, 5, 7, 8, 10, 11, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i Weights = _mm_setr_epi8(10, 1, 10, 1, 10, 1, 10, 1, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i LowNibble = _mm_set1_epi8(0x0F);
+    const __m128i Space = _mm_set1_epi8(' ');
+    const __m128i Zero = _mm_set1_epi8('0' - 1);
+    const __m128i Nine = _mm_set1_epi8('9' + 1);
+    const __m256i One = _mm256_set1_epi64x(1);
+    const __m256i SixtyFour = _mm256_set1_epi64x(64);
+    const __m256i Lanes = _mm256_setr_epi64x(0, 1, 2, 3);
+    __m256i Lo = _mm256_setzero_si256();
+    __m256i Hi = _mm256_setzero_si256();
+    for(int Field = 0; Field < Count; Field += 4)
+    {
+        __m128i Bytes = _mm_loadu_si128((const __m128i*)(Input + 3 * Field));
+
+        // Check for spaces, then tens digits or spaces, then ones digits.
+        int FieldCount = Count - Field < 4 ? Count - Field : 4;
+        uint32_t Used = (1u << (3 * FieldCount)) - 1;
+        __m128i IsDigits = _mm_and_si128(_mm_cmpgt_epi8(Bytes, Zero), _mm_cmpgt_epi8(Nine, Bytes));
+        uint32_t Spaces = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(Bytes, Space));
+        uint32_t Digits = (uint32_t)_mm_movemask_epi8(IsDigits);
+        uint32_t Valid = (Spaces & 0x249) | ((Spaces | Digits) & 0x492) | (Digits & 0x924);
+        if((Valid & Used) != Used) return false;
+
+        // Spaces have a low nibble of zero, so they read as a zero digit.
+        __m128i Pairs = _mm_and_si128(_mm_shuffle_epi8(Bytes, Gather), LowNibble);
+        __m256i Values = _mm256_cvtepu16_epi64(_mm_maddubs_epi16(Pairs, Weights));
+        __m256i InUse = _mm256_cmpgt_epi64(_mm256_set1_epi64x(FieldCount), Lanes);
+        Lo = _mm256_or_si256(Lo, _mm256_and_si256(InUse, _mm256_sllv_epi64(One, Values)));
+        Hi = _mm256_or_si256(Hi, _mm256_and_si256(InUse, _mm256_sllv_epi64(One, _mm256_sub_epi64(Values, SixtyFour))));
+    }
+    __m128i LoHalf = _mm_or_si128(_mm256_castsi256_si128(Lo), _mm256_extracti128_si256(Lo, 1));
+    __m128i HiHalf = _mm_or_si128(_mm256_castsi256_si128(Hi), _mm256_extracti128_si256(Hi, 1));
+    OutSet[0] = (uint64_t)(_mm_cvtsi128_si64(LoHalf) | _mm_extract_epi64(LoHalf, 1));
+    OutSet[1] = (uint64_t)(_mm_cvtsi128_si64(HiHalf) | _mm_extract_epi64(HiHalf, 1));
+    return true;
+}
+
+// Cards are normally laid out with the same number of fixed width fields, so
+// the layout of the first card is used to parse each card with SIMD. Cards
+// that don't match the layout fall back to the general parser.
+typedef struct
+{
+    const char* Input;
+    const char* End;
+    int WinningCount;
+    int OwnCount;
+    winning_set WinningNumbers;
+} card_parser;
+
+static void InitCardParser(card_parser* Parser, const char* Input)
+{
+    Parser->Input = Input;
+    Parser->End = Input + strlen(Input);
+    const char* Fields = SkipPastHeader(Input);
+    const char* Bar = Fields;
+    while(*Bar != '|' && *Bar != '\0') Bar++;
+    Parser->WinningCount = (int)(Bar - Fields) / 3;
+    Parser->OwnCount = (int)(FindLineEnd(Bar) - Bar - 1) / 3;
+    InitWinningSet(&Parser->WinningNumbers);
+}
+
+static void FreeCardParser(card_parser* Parser)
+{
+    FreeWinningSet(&Parser->WinningNumbers);
+}
+
+static bool CardParserMatchLayout(card_parser* Parser, const char* Fields, int* OutMatches)
+{
+    // Fields are loaded 16 bytes at a time, so reading the last one may load up
+    // to 13 bytes past the end of the line.
+    const char* Bar = Fields + 3 * Parser->WinningCount + 1;
+    const char* LineEnd = Bar + 1 + 3 * Parser->OwnCount;
+    if(LineEnd + 13 > Parser->End) return false;
+    if(*Bar != '|' || FindLineEnd(LineEnd) != LineEnd) return false;
+    uint64_t Winning[2], Own[2];
+    if(!FieldsToSet(Fields, Parser->WinningCount, Winning)) return false;
+    if(!FieldsToSet(Bar + 1, Parser->OwnCount, Own)) return false;
+    *OutMatches = (int)(_mm_popcnt_u64(Winning[0] & Own[0]) + _mm_popcnt_u64(Winning[1] & Own[1]));
+    return true;
+}
+
+// Finds the number of matches on the next card. Returns false once all cards
+// have been read.
+static bool CardParserNext(card_parser* Parser, int* OutMatches)
+{
+    const char* Input = Parser->Input;
+    if(!Input || *Input == '\0') return false;
+    const char* Fields = SkipPastHeader(Input);
+    if(CardParserMatchLayout(Parser, Fields, OutMatches))
+    {
+        Input = SkipPastNewline(FindLineEnd(Fields));
+        Parser->Input = *Input ? Input : NULL;
+    }
+    else
+    {
+        Parser->Input = Next(Input, &Parser->WinningNumbers, OutMatches);
+    }
+    return true;
+}
+
 AOC_SOLVER(Part1)
 {
     int64_t Sum = 0;
     int Matches;
-    do
+    card_parser Parser;
+    InitCardParser(&Parser, Input);
+    while(CardParserNext(&Parser, &Matches))
     {
-        Input = Next(Input, &Matches);
-        if(Matches) Sum += 1 << (Matches - 1);
-    } while(Input);
+        if(!Matches) continue;
+        if(Matches > 63) AocOverflow();
+        Sum = AocAdd(Sum, (int64_t)1 << (Matches - 1));
+    }
+    FreeCardParser(&Parser);
     return Sum;
 }
 
+// Pending changes in the number of copies of upcoming cards, as a difference
+// array in a ring buffer. Only the next Capacity cards are ever pending, so
+// the ring stays as small as the largest number of matches.
+typedef struct
+{
+    int64_t* Deltas;
+    aoc_index Capacity;
+} copy_ring;
+
+static void InitCopyRing(copy_ring* Ring, aoc_index MinCapacity)
+{
+    Ring->Capacity = 1;
+    while(Ring->Capacity < MinCapacity) Ring->Capacity *= 2;
+    Ring->Deltas = (int64_t*)calloc(Ring->Capacity, sizeof(int64_t));
+}
+
+static void FreeCopyRing(copy_ring* Ring)
+{
+    free(Ring->Deltas);
+}
+
+// Grows the ring to fit cards up to MinCapacity - 1 after CardIndex.
+static void CopyRingReserve(copy_ring* Ring, aoc_index CardIndex, aoc_index MinCapacity)
+{
+    if(MinCapacity <= Ring->Capacity) return;
+    copy_ring NewRing;
+    InitCopyRing(&NewRing, MinCapacity);
+    for(aoc_index Index = CardIndex; Index < CardIndex + Ring->Capacity; Index++)
+    {
+        NewRing.Deltas[Index & (NewRing.Capacity - 1)] = Ring->Deltas[Index & (Ring->Capacity - 1)];
+    }
+    FreeCopyRing(Ring);
+    *Ring = NewRing;
+}
+
 AOC_SOLVER(Part2)
 {
     int64_t Sum = 0;
+    int64_t Copies = 0;
     int Matches;
-    int CardIndex = 0, Capacity = 256;
-    int* Copies = (int*)calloc(Capacity, sizeof(int));
-    do
+    card_parser Parser;
+    InitCardParser(&Parser, Input);
+    copy_ring Ring;
+    InitCopyRing(&Ring, Parser.WinningCount + 2);
+    for(aoc_index CardIndex = 0; CardParserNext(&Parser, &Matches); CardIndex++)
     {
-        Input = Next(Input, &Matches);
-        int NumCards = 1;
-        if(CardIndex < Capacity)
-        {
-            NumCards += Copies[CardIndex];
-        }
-        Sum += NumCards;
-        for(int Match = 1; Match <= Matches; Match++)
-        {
-            int CopyIndex = CardIndex + Match;
-            while(CopyIndex >= Capacity)
-            {
-                size_t HalfSize = sizeof(int) * Capacity;
-                Capacity *= 2;
-                Copies = (int*)realloc(Copies, sizeof(int) * Capacity);
-                memset(Copies + CopyIndex, 0, HalfSize);
-            }
-            Copies[CopyIndex] += NumCards;
-        }
-        CardIndex++;
-    } while(Input);
+        // Apply and clear this card's change, then add its cards to the next
+        // Matches cards, ending after them.
+        int64_t* Delta = &Ring.Deltas[CardIndex & (Ring.Capacity - 1)];
+        Copies = AocAdd(Copies, *Delta);
+        *Delta = 0;
+        int64_t NumCards = AocAdd(Copies, 1);
+        Sum = AocAdd(Sum, NumCards);
+        if(!Matches) continue;
+        CopyRingReserve(&Ring, CardIndex, Matches + 2);
+        aoc_index Mask = Ring.Capacity - 1;
+        Ring.Deltas[(CardIndex + 1) & Mask] = AocAdd(Ring.Deltas[(CardIndex + 1) & Mask], NumCards);
+        Ring.Deltas[(CardIndex + Matches + 1) & Mask] -= NumCards;
+    }
+    FreeCopyRing(&Ring);
+    FreeCardParser(&Parser);
     return Sum;
 }
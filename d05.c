@@ -1,203 +1,256 @@
 #include "aoc.h"
+#include "array.h"
 #include "parse.h"
 
 const char* DefaultInputPath = "d05.txt";
 
-AOC_SOLVER(Part1)
+SMALL_ARRAY(seed_array, SeedArray, int64_t, 32)
+
+// Maps are piecewise functions made of sorted segments that each add Offset to
+// the values from Start up to End. Gaps between the almanac's ranges map values
+// to themselves, so they're filled with identity segments and every map covers
+// the values from zero up to MAP_LIMIT.
+typedef struct
 {
-    // Parse the seeds.
-    size_t SeedCount = 0;
-    size_t SeedCapacity = 32;
-    int64_t* SeedsIn = (int64_t*)malloc(sizeof(int64_t) * SeedCapacity);
-    Input += 7; // Skip "seeds: "
-    do
-    {
-        if(SeedCount == SeedCapacity)
-        {
-            SeedCapacity *= 2;
-            SeedsIn = (int64_t*)realloc(SeedsIn, sizeof(int64_t) * SeedCapacity);
-        }
-        SeedsIn[SeedCount++] = atoll(Input);
-        Input = SkipPastDigits(Input);
-        Input = SkipPastWhitespace(Input);
-    } while(*Input != '\n');
-    size_t SeedSize = sizeof(int64_t) * SeedCount;
-    int64_t* SeedsOut = (int64_t*)malloc(SeedSize);
-    memcpy(SeedsOut, SeedsIn, SeedSize);
+    int64_t Start;
+    int64_t End;
+    int64_t Offset;
+} segment;
 
-    // Parse and apply each seed mapping.
-    while(*Input != '\0')
+ARRAY(segment_array, SegmentArray, segment)
+
+#define MAP_LIMIT ((int64_t)1 << 62)
+
+// Adds a segment after the last one, merging the two when they line up.
+static void AddSegment(segment_array* Map, int64_t Start, int64_t End, int64_t Offset)
+{
+    if(Start >= End) return;
+    if(Map->Count)
     {
-        Input = SkipToDigits(Input);
-        while(IsDigit(*Input))
+        segment* Last = &Map->Elements[Map->Count - 1];
+        if(Last->End == Start && Last->Offset == Offset)
         {
-            int64_t Dest = atoll(Input);
-            Input = SkipPastDigits(Input);
-            Input = SkipPastWhitespace(Input);
-            int64_t RangeStart = atoll(Input);
-            Input = SkipPastDigits(Input);
-            Input = SkipPastWhitespace(Input);
-            int64_t RangeEnd = RangeStart + atoll(Input);
-            for(int Index = 0; Index < SeedCount; Index++)
-            {
-                int64_t Seed = SeedsIn[Index];
-                if(Seed >= RangeStart && Seed < RangeEnd)
-                {
-                    SeedsOut[Index] = Dest + Seed - RangeStart;
-                }
-            }
-            Input = SkipPastDigits(Input);
-            Input = SkipPastNewline(Input);
+            Last->End = End;
+            return;
         }
-        memcpy(SeedsIn, SeedsOut, SeedSize);
     }
+    SegmentArrayAdd(Map, (segment){.Start = Start, .End = End, .Offset = Offset});
+}
 
-    // Find the lowest seed.
-    int64_t LowestSeed = INT64_MAX;
-    for(int Index = 0; Index < SeedCount; Index++)
+// Returns the index of the segment containing Value.
+static size_t FindSegment(const segment_array* Map, int64_t Value)
+{
+    size_t Lo = 0;
+    size_t Hi = Map->Count - 1;
+    while(Lo < Hi)
     {
-        int64_t Seed = SeedsOut[Index];
-        if(Seed < LowestSeed) LowestSeed = Seed;
+        size_t Mid = Lo + (Hi - Lo + 1) / 2;
+        if(Map->Elements[Mid].Start <= Value) Lo = Mid;
+        else Hi = Mid - 1;
     }
-
-    free(SeedsIn);
-    free(SeedsOut);
-    return LowestSeed;
+    return Lo;
 }
 
-typedef struct
+static int CompareSegments(const void* A, const void* B)
 {
-    int64_t Start;
-    int64_t End;
-} range;
+    int64_t StartA = ((const segment*)A)->Start;
+    int64_t StartB = ((const segment*)B)->Start;
+    return (StartA > StartB) - (StartA < StartB);
+}
 
-typedef struct
+static const char* ParseSeeds(const char* Input, seed_array* Seeds)
 {
-    range* Elements;
-    size_t Count;
-    size_t Capacity;
-} range_array;
+    InitSeedArray(Seeds);
+    Input += 7; // Skip "seeds: "
+    do
+    {
+        SeedArrayAdd(Seeds, atoll(Input));
+        Input = SkipPastDigits(Input);
+        Input = SkipPastWhitespace(Input);
+    } while(*Input != '\n');
+    return Input;
+}
 
-void InitRangeArray(range_array* Array)
+// Parses the lines of the next map into its segments, in order and with the
+// gaps between them filled.
+static const char* ParseMap(const char* Input, segment_array* Ranges, segment_array* Map)
 {
-    Array->Elements = NULL;
-    Array->Count = 0;
-    Array->Capacity = 0;
+    SegmentArrayReset(Ranges);
+    Input = SkipToDigits(Input);
+    while(IsDigit(*Input))
+    {
+        int64_t Dest = atoll(Input);
+        Input = SkipPastDigits(Input);
+        Input = SkipPastWhitespace(Input);
+        int64_t Start = atoll(Input);
+        Input = SkipPastDigits(Input);
+        Input = SkipPastWhitespace(Input);
+        int64_t End = Start + atoll(Input);
+        SegmentArrayAdd(Ranges, (segment){.Start = Start, .End = End, .Offset = Dest - Start});
+        Input = SkipPastDigits(Input);
+        Input = SkipPastNewline(Input);
+    }
+    qsort(Ranges->Elements, Ranges->Count, sizeof(segment), CompareSegments);
+
+    SegmentArrayReset(Map);
+    int64_t Covered = 0;
+    for(size_t Index = 0; Index < Ranges->Count; Index++)
+    {
+        segment Range = Ranges->Elements[Index];
+        AddSegment(Map, Covered, Range.Start, 0);
+        AddSegment(Map, Range.Start, Range.End, Range.Offset);
+        Covered = Range.End;
+    }
+    AddSegment(Map, Covered, MAP_LIMIT, 0);
+    return Input;
 }
 
-void FreeRangeArray(range_array* Array)
+// Composes First then Second into Out. Each segment of First is split where
+// its values land on the segments of Second, so Out stays in order.
+static void ComposeMaps(const segment_array* First, const segment_array* Second, segment_array* Out)
 {
-    free(Array->Elements);
+    SegmentArrayReset(Out);
+    for(size_t Index = 0; Index < First->Count; Index++)
+    {
+        segment Segment = First->Elements[Index];
+        int64_t Start = Segment.Start + Segment.Offset;
+        int64_t End = Segment.End + Segment.Offset;
+        for(size_t Next = FindSegment(Second, Start); Start < End; Next++)
+        {
+            segment Target = Second->Elements[Next];
+            int64_t TargetEnd = Target.End < End ? Target.End : End;
+            AddSegment(Out, Start - Segment.Offset, TargetEnd - Segment.Offset, Segment.Offset + Target.Offset);
+            Start = TargetEnd;
+        }
+    }
 }
 
-void RangeArrayAdd(range_array* Array, int64_t Start, int64_t End)
+// Parses the seeds and composes all of the maps into a single map from seeds
+// to locations, which answers any number of seed queries.
+static void ParseAlmanac(const char* Input, seed_array* Seeds, segment_array* Almanac)
 {
-    size_t Capacity = Array->Capacity;
-    if(Array->Count == Capacity)
+    Input = ParseSeeds(Input, Seeds);
+    segment_array Ranges, Map, Composed;
+    InitSegmentArray(&Ranges);
+    InitSegmentArray(&Map);
+    InitSegmentArray(&Composed);
+    InitSegmentArray(Almanac);
+    AddSegment(Almanac, 0, MAP_LIMIT, 0);
+    while(*Input != '\0')
     {
-        Capacity = Capacity ? 2 * Capacity : 8;
-        Array->Elements = (range*)realloc(Array->Elements, sizeof(range) * Capacity);
-        Array->Capacity = Capacity;
+        Input = ParseMap(Input, &Ranges, &Map);
+        ComposeMaps(Almanac, &Map, &Composed);
+        SegmentArraySwap(Almanac, &Composed);
     }
-    Array->Elements[Array->Count++] = (range){.Start = Start, .End = End};
+    FreeSegmentArray(&Ranges);
+    FreeSegmentArray(&Map);
+    FreeSegmentArray(&Composed);
 }
 
-void RangeArrayReset(range_array* Array)
+AOC_SOLVER(Part1)
 {
-    Array->Count = 0;
+    seed_array Seeds;
+    segment_array Almanac;
+    ParseAlmanac(Input, &Seeds, &Almanac);
+
+    int64_t LowestLocation = INT64_MAX;
+    for(size_t Index = 0; Index < Seeds.Count; Index++)
+    {
+        int64_t Seed = Seeds.Elements[Index];
+        int64_t Location = Seed + Almanac.Elements[FindSegment(&Almanac, Seed)].Offset;
+        if(Location < LowestLocation) LowestLocation = Location;
+    }
+
+    FreeSeedArray(&Seeds);
+    FreeSegmentArray(&Almanac);
+    return LowestLocation;
 }
 
-AOC_SOLVER(Part2)
+// Sets of values are kept as sorted ranges that neither overlap nor touch, so
+// they stay as small as possible however many ranges they're made from.
+typedef struct
 {
-    range_array SeedRangesIn, SeedRangesOut;
-    InitRangeArray(&SeedRangesIn);
-    InitRangeArray(&SeedRangesOut);
+    int64_t Start;
+    int64_t End;
+} range;
 
-    // Parse the ranges.
-    Input += 7; // Skip "seeds: "
-    do
-    {
-        int64_t Start = atoll(Input);
-        Input = SkipPastDigits(Input);
-        Input = SkipPastWhitespace(Input);
-        int64_t End = Start + atoll(Input);
-        Input = SkipPastDigits(Input);
-        Input = SkipPastWhitespace(Input);
-        RangeArrayAdd(&SeedRangesIn, Start, End);
-    } while(*Input != '\n');
+ARRAY(range_array, RangeArray, range)
 
-    // Parse and apply each seed mapping.
-    while(*Input != '\0')
+static int CompareRanges(const void* A, const void* B)
+{
+    int64_t StartA = ((const range*)A)->Start;
+    int64_t StartB = ((const range*)B)->Start;
+    return (StartA > StartB) - (StartA < StartB);
+}
+
+// Sorts a batch of ranges into a set, merging any that overlap or touch and
+// dropping empty ones.
+static void CoalesceRanges(range_array* Ranges)
+{
+    qsort(Ranges->Elements, Ranges->Count, sizeof(range), CompareRanges);
+    size_t Count = 0;
+    for(size_t Index = 0; Index < Ranges->Count; Index++)
     {
-        Input = SkipToDigits(Input);
-        while(IsDigit(*Input))
+        range Range = Ranges->Elements[Index];
+        if(Range.Start >= Range.End) continue;
+        if(Count && Range.Start <= Ranges->Elements[Count - 1].End)
         {
-            int64_t Dest = atoll(Input);
-            Input = SkipPastDigits(Input);
-            Input = SkipPastWhitespace(Input);
-            int64_t RangeStart = atoll(Input);
-            Input = SkipPastDigits(Input);
-            Input = SkipPastWhitespace(Input);
-            int64_t RangeEnd = RangeStart + atoll(Input);
-            for(int Index = 0; Index < SeedRangesIn.Count; Index++)
-            {
-                range SeedRange = SeedRangesIn.Elements[Index];
-                if(RangeEnd <= SeedRange.Start) continue;
-                if(RangeStart >= SeedRange.End) continue;
-                if(RangeStart <= SeedRange.Start && RangeEnd >= SeedRange.End)
-                {
-                    int64_t DestStart = Dest + SeedRange.Start - RangeStart;
-                    int64_t DestEnd = DestStart + SeedRange.End - SeedRange.Start;
-                    RangeArrayAdd(&SeedRangesOut, DestStart, DestEnd);
-                    SeedRangesIn.Elements[Index] = (range){.Start = -1, .End = -1};
-                }
-                else if(RangeStart <= SeedRange.Start)
-                {
-                    int64_t DestStart = Dest + SeedRange.Start - RangeStart;
-                    int64_t DestEnd = DestStart + RangeEnd - SeedRange.Start;
-                    RangeArrayAdd(&SeedRangesOut, DestStart, DestEnd);
-                    SeedRangesIn.Elements[Index].Start = RangeEnd;
-                }
-                else if(RangeEnd >= SeedRange.End)
-                {
-                    int64_t DestStart = Dest;
-                    int64_t DestEnd = DestStart + SeedRange.End - RangeStart;
-                    SeedRangesIn.Elements[Index].End = RangeStart;
-                    RangeArrayAdd(&SeedRangesOut, DestStart, DestEnd);
-                }
-                else
-                {
-                    int64_t DestStart = Dest;
-                    int64_t DestEnd = DestStart + RangeEnd - RangeStart;
-                    SeedRangesIn.Elements[Index].End = RangeStart;
-                    RangeArrayAdd(&SeedRangesOut, DestStart, DestEnd);
-                    RangeArrayAdd(&SeedRangesIn, RangeEnd, SeedRange.End);
-                }
-            }
-            Input = SkipPastDigits(Input);
-            Input = SkipPastNewline(Input);
+            range* Last = &Ranges->Elements[Count - 1];
+            if(Range.End > Last->End) Last->End = Range.End;
+            continue;
         }
-        for(int Index = 0; Index < SeedRangesIn.Count; Index++)
+        Ranges->Elements[Count++] = Range;
+    }
+    Ranges->Count = Count;
+}
+
+// Maps every value in a set into Out. Both the set and the map are sorted, so
+// they're split against each other in a single pass, then the translated
+// pieces are coalesced.
+static void MapRanges(const range_array* Ranges, const segment_array* Map, range_array* Out)
+{
+    RangeArrayReset(Out);
+    if(!Ranges->Count) return;
+    size_t Next = FindSegment(Map, Ranges->Elements[0].Start);
+    for(size_t Index = 0; Index < Ranges->Count; Index++)
+    {
+        range Range = Ranges->Elements[Index];
+        while(Map->Elements[Next].End <= Range.Start) Next++;
+        for(int64_t Start = Range.Start;; Next++)
         {
-            range SeedRange = SeedRangesIn.Elements[Index];
-            if(SeedRange.Start >= SeedRange.End) continue;
-            RangeArrayAdd(&SeedRangesOut, SeedRange.Start, SeedRange.End);
+            // Stay on the last segment, as the next range may start in it.
+            segment Segment = Map->Elements[Next];
+            int64_t End = Segment.End < Range.End ? Segment.End : Range.End;
+            RangeArrayAdd(Out, (range){.Start = Start + Segment.Offset, .End = End + Segment.Offset});
+            if(End == Range.End) break;
+            Start = End;
         }
-        range_array SeedRangesTemp = SeedRangesOut;
-        SeedRangesOut = SeedRangesIn;
-        SeedRangesIn = SeedRangesTemp;
-        RangeArrayReset(&SeedRangesOut);
     }
+    CoalesceRanges(Out);
+}
+
+AOC_SOLVER(Part2)
+{
+    seed_array Seeds;
+    segment_array Almanac;
+    ParseAlmanac(Input, &Seeds, &Almanac);
 
-    // Find the lowest seed.
-    int64_t LowestSeed = INT64_MAX;
-    for(int Index = 0; Index < SeedRangesIn.Count; Index++)
+    range_array SeedRanges, Locations;
+    InitRangeArray(&SeedRanges);
+    InitRangeArray(&Locations);
+    RangeArrayReserve(&SeedRanges, Seeds.Count / 2);
+    for(size_t Index = 0; Index + 1 < Seeds.Count; Index += 2)
     {
-        int64_t Seed = SeedRangesIn.Elements[Index].Start;
-        if(Seed < LowestSeed) LowestSeed = Seed;
+        int64_t Start = Seeds.Elements[Index];
+        RangeArrayAdd(&SeedRanges, (range){.Start = Start, .End = Start + Seeds.Elements[Index + 1]});
     }
+    CoalesceRanges(&SeedRanges);
+    MapRanges(&SeedRanges, &Almanac, &Locations);
+    int64_t LowestLocation = Locations.Count ? Locations.Elements[0].Start : INT64_MAX;
 
-    FreeRangeArray(&SeedRangesIn);
-    FreeRangeArray(&SeedRangesOut);
-    return LowestSeed;
+    FreeSeedArray(&Seeds);
+    FreeSegmentArray(&Almanac);
+    FreeRangeArray(&SeedRanges);
+    FreeRangeArray(&Locations);
+    return LowestLocation;
 }
@@ -1,31 +1,121 @@
 #include "aoc.h"
+#include "array.h"
 #include "parse.h"
 
+#include <immintrin.h>
+
 const char* DefaultInputPath = "d06.txt";
 
-static int64_t MarginForError(double Time, double Dist)
+SMALL_ARRAY(number_array, NumberArray, int64_t, 8)
+
+// Races are solved exactly in 128-bit integers, as the square of a 64-bit time
+// doesn't fit in 64 bits.
+__extension__ typedef __int128 int128;
+__extension__ typedef unsigned __int128 uint128;
+
+// Finds the largest integer whose square is at most Value. A double estimate
+// is within a few parts in 2^52 of the root, so a binary search within that
+// margin corrects it.
+static uint64_t SquareRoot(uint128 Value)
 {
-    double Disc = sqrt(Time * Time - 4 * Dist);
-    int64_t Lo = (int64_t)floor((Time - Disc)/2 + 1);
-    int64_t Hi = (int64_t)ceil((Time + Disc)/2 - 1);
-    return Hi - Lo + 1;
+    double Approx = (double)(uint64_t)(Value >> 64) * 18446744073709551616.0 + (double)(uint64_t)Value;
+    uint64_t Estimate = (uint64_t)sqrt(Approx);
+    uint64_t Margin = (Estimate >> 50) + 2;
+    uint64_t Lo = Estimate > Margin ? Estimate - Margin : 0;
+    uint64_t Hi = Estimate + Margin;
+    while(Lo < Hi)
+    {
+        uint64_t Mid = Lo + (Hi - Lo + 1) / 2;
+        if((uint128)Mid * Mid <= Value) Lo = Mid;
+        else Hi = Mid - 1;
+    }
+    return Lo;
 }
 
-AOC_SOLVER(Part1)
+// Holding for H wins when H * (Time - H) > Dist, which is between the roots of
+// H^2 - Time * H + Dist. With Root the integer square root of the
+// discriminant, the first winning hold is (Time - Root) / 2 or one after it,
+// and the winning holds are symmetric about Time / 2.
+static int64_t MarginForError(int64_t Time, int64_t Dist)
 {
-    double Times[4];
-    double Dists[4];
-    int Count = 0;
+    int128 Disc = (int128)Time * Time - (int128)4 * Dist;
+    int64_t Root = Disc > 0 ? (int64_t)SquareRoot((uint128)Disc) : 0;
+    int64_t Hold = (Time - Root) / 2;
+    if((int128)Hold * (Time - Hold) <= Dist) Hold++;
+    int64_t Margin = Time - 2 * Hold + 1;
+    return Margin > 0 ? Margin : 0;
+}
+
+// Converts integers in [0, 2^52) to doubles, by placing them in the mantissa
+// of 2^52 and subtracting it.
+static __m256d IntToDouble(__m256i Value)
+{
+    const __m256d Magic = _mm256_set1_pd(4503599627370496.0);
+    return _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(Value, _mm256_castpd_si256(Magic))), Magic);
+}
+
+// Solves four races at once as MarginForError, in doubles. This is exact when
+// Time^2 and 4 * Dist fit in the 53 bits of a double's mantissa.
+static __m128i MarginForError4(__m256i Times, __m256i Dists)
+{
+    const __m256d Zero = _mm256_setzero_pd();
+    const __m256d One = _mm256_set1_pd(1.0);
+    const __m256d Half = _mm256_set1_pd(0.5);
+    __m256d Time = IntToDouble(Times);
+    __m256d Dist = IntToDouble(Dists);
+    __m256d Disc = _mm256_max_pd(_mm256_sub_pd(_mm256_mul_pd(Time, Time), _mm256_mul_pd(_mm256_set1_pd(4.0), Dist)), Zero);
+
+    // The rounded square root may be one too high just below a square.
+    __m256d Root = _mm256_floor_pd(_mm256_sqrt_pd(Disc));
+    __m256d TooHigh = _mm256_cmp_pd(_mm256_mul_pd(Root, Root), Disc, _CMP_GT_OQ);
+    Root = _mm256_sub_pd(Root, _mm256_and_pd(TooHigh, One));
+
+    __m256d Hold = _mm256_floor_pd(_mm256_mul_pd(_mm256_sub_pd(Time, Root), Half));
+    __m256d Loses = _mm256_cmp_pd(_mm256_mul_pd(Hold, _mm256_sub_pd(Time, Hold)), Dist, _CMP_LE_OQ);
+    Hold = _mm256_add_pd(Hold, _mm256_and_pd(Loses, One));
+    __m256d Margin = _mm256_add_pd(_mm256_sub_pd(Time, _mm256_add_pd(Hold, Hold)), One);
+    return _mm256_cvttpd_epi32(_mm256_max_pd(Margin, Zero));
+}
 
-    // Parse input;
-    double* Data[2] = { Times, Dists };
+// Writes the margin for error of each race, four at a time where the races are
+// small enough to solve in doubles.
+static void SolveRaces(const int64_t* Times, const int64_t* Dists, aoc_index Count, int64_t* OutMargins)
+{
+    const __m256i MaxTime = _mm256_set1_epi64x((1 << 26) - 1);
+    const __m256i MaxDist = _mm256_set1_epi64x(((int64_t)1 << 50) - 1);
+    aoc_index Index = 0;
+    for(; Index + 4 <= Count; Index += 4)
+    {
+        __m256i Time = _mm256_loadu_si256((const __m256i*)(Times + Index));
+        __m256i Dist = _mm256_loadu_si256((const __m256i*)(Dists + Index));
+        __m256i Large = _mm256_or_si256(_mm256_cmpgt_epi64(Time, MaxTime), _mm256_cmpgt_epi64(Dist, MaxDist));
+        if(!_mm256_testz_si256(Large, Large))
+        {
+            for(int Lane = 0; Lane < 4; Lane++)
+            {
+                OutMargins[Index + Lane] = MarginForError(Times[Index + Lane], Dists[Index + Lane]);
+            }
+            continue;
+        }
+        __m256i Margins = _mm256_cvtepi32_epi64(MarginForError4(Time, Dist));
+        _mm256_storeu_si256((__m256i*)(OutMargins + Index), Margins);
+    }
+    for(; Index < Count; Index++)
+    {
+        OutMargins[Index] = MarginForError(Times[Index], Dists[Index]);
+    }
+}
+
+AOC_SOLVER(Part1)
+{
+    number_array Data[2];
     for(int Index = 0; Index < 2; Index++)
     {
-        Count = 0;
+        InitNumberArray(&Data[Index]);
         Input = SkipToDigits(Input);
         while(IsDigit(*Input))
         {
-            Data[Index][Count++] = (double)atoi(Input);
+            NumberArrayAdd(&Data[Index], atoll(Input));
             Input = SkipPastDigits(Input);
             Input = SkipPastWhitespace(Input);
         }
@@ -33,17 +123,24 @@ AOC_SOLVER(Part1)
     }
 
     // Calculate product of margins of error in each record.
+    aoc_index Count = Data[0].Count < Data[1].Count ? Data[0].Count : Data[1].Count;
+    int64_t* Margins = (int64_t*)malloc(sizeof(int64_t) * (Count + 1));
+    SolveRaces(Data[0].Elements, Data[1].Elements, Count, Margins);
     int64_t Product = 1;
-    for(int Index = 0; Index < Count; Index++)
+    for(aoc_index Index = 0; Index < Count; Index++)
     {
-        Product *= MarginForError(Times[Index], Dists[Index]);
+        Product = AocMul(Product, Margins[Index]);
     }
+
+    free(Margins);
+    FreeNumberArray(&Data[0]);
+    FreeNumberArray(&Data[1]);
     return Product;
 }
 
 AOC_SOLVER(Part2)
 {
-    double Data[2];
+    int64_t Data[2];
     for(int Index = 0; Index < 2; Index++)
     {
         int64_t Number = 0;
@@ -53,14 +150,14 @@ AOC_SOLVER(Part2)
             char C = *Input++;
             if(IsDigit(C))
             {
-                Number = (Number * 10) + (C - '0');
+                Number = AocAdd(AocMul(Number, 10), C - '0');
             }
             else if(C != ' ')
             {
                 break;
             }
         }
-        Data[Index] = (double)Number;
+        Data[Index] = Number;
         Input = SkipPastNewline(Input);
     }
     return MarginForError(Data[0], Data[1]);
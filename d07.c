@@ -1,206 +1,128 @@
 #include "aoc.h"
+#include "array.h"
+#include "gen/d07_tables.h"
 #include "parse.h"
 
 const char* DefaultInputPath = "d07.txt";
 
-enum
-{
-    RANK_JOKER,
-    RANK_2,
-    RANK_3,
-    RANK_4,
-    RANK_5,
-    RANK_6,
-    RANK_7,
-    RANK_8,
-    RANK_9,
-    RANK_T,
-    RANK_J,
-    RANK_Q,
-    RANK_K,
-    RANK_A,
-    NUM_RANKS
-};
-
-enum
-{
-    TYPE_HIGH_CARD,
-    TYPE_ONE_PAIR,
-    TYPE_TWO_PAIR,
-    TYPE_THREE_OF_A_KIND,
-    TYPE_FULL_HOUSE,
-    TYPE_FOUR_OF_A_KIND,
-    TYPE_FIVE_OF_A_KIND
-};
-
 typedef struct
 {
     uint32_t Cards;
     int32_t Bid;
 } hand;
 
-typedef struct
-{
-    hand* Elements;
-    size_t Count;
-    size_t Capacity;
-} hand_array;
+ARRAY(hand_array, HandArray, hand)
 
-static void InitHandArray(hand_array* Array)
-{
-    Array->Elements = NULL;
-    Array->Count = 0;
-    Array->Capacity = 0;
-}
-
-static void FreeHandArray(hand_array* Array)
-{
-    free(Array->Elements);
-    InitHandArray(Array);
-}
+// Hands are sorted by a least significant digit radix sort on their 24-bit
+// keys, one byte per pass. The counts for every pass are gathered up front,
+// and passes where every hand has the same byte are skipped.
+#define SORT_PASSES (3)
 
-static void HandArrayAdd(hand_array* Array, uint32_t Cards, int32_t Bid)
+static void HandArraySort(hand_array* Array)
 {
-    size_t Capacity = Array->Capacity;
-    if(Array->Count == Capacity)
+    aoc_index Count = Array->Count;
+    aoc_index Offsets[SORT_PASSES][256];
+    memset(Offsets, 0, sizeof(Offsets));
+    for(aoc_index Index = 0; Index < Count; Index++)
     {
-        Capacity = Capacity ? 2 * Capacity : 8;
-        Array->Elements = (hand*)realloc(Array->Elements, sizeof(hand) * Capacity);
-        Array->Capacity = Capacity;
+        uint32_t Cards = Array->Elements[Index].Cards;
+        for(int Pass = 0; Pass < SORT_PASSES; Pass++)
+        {
+            Offsets[Pass][(Cards >> (8 * Pass)) & 255]++;
+        }
     }
-    Array->Elements[Array->Count++] = (hand){.Cards = Cards, .Bid = Bid};
-}
 
-static void HandArraySwap(hand* Hands, int FromIndex, int ToIndex)
-{
-    hand Temp = Hands[ToIndex];
-    Hands[ToIndex] = Hands[FromIndex];
-    Hands[FromIndex] = Temp;
-}
-
-static int HandArrayPartition(hand* Hands, int LoIndex, int HiIndex)
-{
-    hand Pivot = Hands[HiIndex];
-    int PivotIndex = LoIndex - 1;
-    for(int TestIndex = LoIndex; TestIndex < HiIndex; TestIndex++)
+    hand* From = Array->Elements;
+    hand* To = (hand*)malloc(sizeof(hand) * Count);
+    hand* Buffer = To;
+    for(int Pass = 0; Pass < SORT_PASSES; Pass++)
     {
-        if(Hands[TestIndex].Cards <= Pivot.Cards)
+        aoc_index* PassOffsets = Offsets[Pass];
+        if(Count && PassOffsets[(From[0].Cards >> (8 * Pass)) & 255] == Count) continue;
+
+        // Turn the counts into the offset of each byte's first hand.
+        aoc_index Offset = 0;
+        for(int Byte = 0; Byte < 256; Byte++)
+        {
+            aoc_index ByteCount = PassOffsets[Byte];
+            PassOffsets[Byte] = Offset;
+            Offset += ByteCount;
+        }
+        for(aoc_index Index = 0; Index < Count; Index++)
         {
-            HandArraySwap(Hands, ++PivotIndex, TestIndex);
+            hand Hand = From[Index];
+            To[PassOffsets[(Hand.Cards >> (8 * Pass)) & 255]++] = Hand;
         }
+        hand* Temp = From;
+        From = To;
+        To = Temp;
     }
-    HandArraySwap(Hands, ++PivotIndex, HiIndex);
-    return PivotIndex;
+
+    if(From != Array->Elements) memcpy(Array->Elements, From, sizeof(hand) * Count);
+    free(Buffer);
 }
 
-static void HandArrayQuickSort(hand* Hands, int LoIndex, int HiIndex)
+// Gathers the flags in the low bit of each of the ten nibbles of Flags.
+static uint32_t GatherNibbleFlags(uint64_t Flags)
 {
-    if(LoIndex >= HiIndex || LoIndex < 0) return;
-    int Pivot = HandArrayPartition(Hands, LoIndex, HiIndex);
-    HandArrayQuickSort(Hands, LoIndex, Pivot - 1);
-    HandArrayQuickSort(Hands, Pivot + 1, HiIndex);
+    Flags = (Flags | (Flags >> 3)) & 0x0303030303ull;
+    Flags = (Flags | (Flags >> 6)) & 0x000F000F000Full;
+    Flags = (Flags | (Flags >> 12)) & 0x000000FF000000FFull;
+    return (uint32_t)((Flags | (Flags >> 24)) & 0x3FF);
 }
 
-static void HandArraySort(hand_array* Array)
+// Sets the low bit of each nibble of Value that is zero.
+static uint64_t ZeroNibbles(uint64_t Value)
 {
-    HandArrayQuickSort(Array->Elements, 0, Array->Count - 1);
+    return ~(Value | (Value >> 1) | (Value >> 2) | (Value >> 3)) & 0x1111111111ull;
 }
 
-static uint8_t ToType(int* CountCounts)
+// A hand's type depends only on which of its cards are equal. Comparing the
+// cards with themselves rotated by one and two cards compares every pair, so
+// bit N is set when card N equals card N + 1 and bit 5 + N when card N equals
+// card N + 2, wrapping around.
+static uint32_t EqualMask(uint32_t Cards)
 {
-    switch(CountCounts[1])
-    {
-    case 0:
-        return CountCounts[5] ? TYPE_FIVE_OF_A_KIND : TYPE_FULL_HOUSE;
-    case 1:
-        return CountCounts[4] ? TYPE_FOUR_OF_A_KIND : TYPE_TWO_PAIR;
-    case 2:
-        return TYPE_THREE_OF_A_KIND;
-    case 3:
-        return TYPE_ONE_PAIR;
-    case 5:
-    default:
-        return TYPE_HIGH_CARD;
-    }
+    uint64_t Next = ((Cards >> 4) | (Cards << 16)) & 0xFFFFF;
+    uint64_t AfterNext = ((Cards >> 8) | (Cards << 12)) & 0xFFFFF;
+    return GatherNibbleFlags(ZeroNibbles((Cards ^ Next) | ((Cards ^ AfterNext) << 20)));
 }
 
-int64_t Solve(const char* Input, bool UseJokers)
+// Sets bit N when card N is a joker.
+static uint32_t JokerMask(uint32_t Cards)
 {
-    // Create the ASCII-to-rank lookup table.
-    uint8_t CharToRank[UINT8_MAX + 1];
-    memset(CharToRank, RANK_JOKER, sizeof(CharToRank));
-    CharToRank['2'] = RANK_2;
-    CharToRank['3'] = RANK_3;
-    CharToRank['4'] = RANK_4;
-    CharToRank['5'] = RANK_5;
-    CharToRank['6'] = RANK_6;
-    CharToRank['7'] = RANK_7;
-    CharToRank['8'] = RANK_8;
-    CharToRank['9'] = RANK_9;
-    CharToRank['T'] = RANK_T;
-    CharToRank['J'] = UseJokers ? RANK_JOKER : RANK_J;
-    CharToRank['Q'] = RANK_Q;
-    CharToRank['K'] = RANK_K;
-    CharToRank['A'] = RANK_A;
+    return GatherNibbleFlags(ZeroNibbles(Cards | 0xFFFFF00000ull)) & 0x1F;
+}
 
+int64_t Solve(const char* Input, bool UseJokers)
+{
     // Parse and determine the type of each hand.
     hand_array Hands;
     InitHandArray(&Hands);
+    HandArrayReserve(&Hands, strlen(Input) / 8); // At least 8 chars per hand.
     while(*Input != '\0')
     {
-        int RankCounts[NUM_RANKS];
-        memset(RankCounts, 0, sizeof(RankCounts));
         uint32_t Cards = 0;
         for(int Card = 0; Card < 5; Card++)
         {
-            uint8_t Rank = CharToRank[*Input++];
-            Cards = (Cards << 4) | Rank;
-            RankCounts[Rank]++;
-        }
-
-        if(UseJokers)
-        {
-            int JokerCount = RankCounts[RANK_JOKER];
-            if(JokerCount > 0)
-            {
-                int BestCount = 0;
-                int BestRank = RANK_JOKER;
-                for(int Rank = RANK_2; Rank < NUM_RANKS; Rank++)
-                {
-                    int RankCount = RankCounts[Rank];
-                    if(RankCount >= BestCount)
-                    {
-                        BestCount = RankCount;
-                        BestRank = Rank;
-                    }
-                }
-                RankCounts[RANK_JOKER] = 0;
-                RankCounts[BestRank] += JokerCount;
-            }
-        }
-
-        int CountCounts[6];
-        memset(CountCounts, 0, sizeof(CountCounts));
-        for(int Rank = RANK_2; Rank < NUM_RANKS; Rank++)
-        {
-            CountCounts[RankCounts[Rank]]++;
+            Cards = (Cards << 4) | CharToRank[UseJokers][(uint8_t)*Input++];
         }
-        Cards |= ToType(CountCounts) << 20;
+        Cards |= (uint32_t)HandTypes[UseJokers ? JokerMask(Cards) : 0][EqualMask(Cards)] << 20;
 
         Input++;
         int Bid = atol(Input);
         Input = SkipPastDigits(Input);
         Input = SkipPastNewline(Input);
 
-        HandArrayAdd(&Hands, Cards, Bid);
+        HandArrayAdd(&Hands, (hand){.Cards = Cards, .Bid = Bid});
     }
 
     // Sort the hands and determine the total winnings.
     HandArraySort(&Hands);
-    int Sum = 0;
-    for(int Index = 0; Index < Hands.Count; Index++)
+    int64_t Sum = 0;
+    for(aoc_index Index = 0; Index < Hands.Count; Index++)
     {
-        Sum += (Index + 1) * Hands.Elements[Index].Bid;
+        Sum = AocAdd(Sum, AocMul(Index + 1, Hands.Elements[Index].Bid));
     }
 
     FreeHandArray(&Hands);
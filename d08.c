@@ -1,4 +1,6 @@
 #include "aoc.h"
+#include "array.h"
+#include "bitset.h"
 #include "parse.h"
 
 const char* DefaultInputPath = "d08.txt";
@@ -19,58 +21,228 @@ static const char* ParseNode(const char* At, uint16_t* OutNode)
     return At + 3;
 }
 
+static char LastChar(uint16_t Node)
+{
+    // Each char takes up 5 bits. 31 = 0b11111 to mask off the last char's offset.
+    return 'A' + (Node & 31);
+}
+
 typedef struct
 {
     uint16_t Left;
     uint16_t Right;
 } ins;
 
-AOC_SOLVER(Part1)
+ARRAY(ins_array, InsArray, ins)
+ARRAY(node_array, NodeArray, uint16_t)
+
+#define NAME_LIMIT (MakeNode('Z', 'Z', 'Z') + 1)
+#define NO_NODE (UINT16_MAX)
+
+// Nodes are numbered densely in the order they're named, so the instructions
+// of every node fit in a small array. Names holds the name of each node, and
+// EndsInA and EndsInZ flag the ghosts' start and end nodes.
+typedef struct
+{
+    const char* Instructions;
+    int64_t InstructionCount;
+    ins_array Ins;
+    node_array Names;
+    bit_set EndsInA;
+    bit_set EndsInZ;
+} network;
+
+static uint16_t NetworkNode(network* Network, uint16_t* Nodes, uint16_t Name)
+{
+    if(Nodes[Name] == NO_NODE)
+    {
+        // Nodes that are never described lead back to themselves.
+        uint16_t Node = (uint16_t)Network->Names.Count;
+        Nodes[Name] = Node;
+        NodeArrayAdd(&Network->Names, Name);
+        InsArrayAdd(&Network->Ins, (ins){.Left = Node, .Right = Node});
+    }
+    return Nodes[Name];
+}
+
+static void ParseNetwork(network* Network, const char* Input)
 {
-    // Parse the map.
-    uint16_t ZZZ = MakeNode('Z', 'Z', 'Z');;
-    ins* Ins = (ins*)calloc(ZZZ + 1, sizeof(ins));
+    Network->Instructions = Input;
+    Network->InstructionCount = 0;
+    while(*Input == 'L' || *Input == 'R')
+    {
+        Network->InstructionCount++;
+        Input++;
+    }
+    InitInsArray(&Network->Ins);
+    InitNodeArray(&Network->Names);
+    uint16_t* Nodes = (uint16_t*)malloc(sizeof(uint16_t) * NAME_LIMIT);
+    memset(Nodes, 0xFF, sizeof(uint16_t) * NAME_LIMIT);
     const char* At = SkipPastLine(Input);
     At = SkipPastLine(At);
     while(IsUpper(*At))
     {
-        uint16_t Node, Left, Right;
-        At = ParseNode(At, &Node) + 4;
+        uint16_t Name, Left, Right;
+        At = ParseNode(At, &Name) + 4;
         At = ParseNode(At, &Left) + 2;
         At = ParseNode(At, &Right) + 1;
         At = SkipPastNewline(At);
-        Ins[Node] = (ins){.Left = Left, .Right = Right};
+        uint16_t Node = NetworkNode(Network, Nodes, Name);
+        Left = NetworkNode(Network, Nodes, Left);
+        Right = NetworkNode(Network, Nodes, Right);
+        Network->Ins.Elements[Node] = (ins){.Left = Left, .Right = Right};
+    }
+    free(Nodes);
+
+    InitBitSet(&Network->EndsInA, Network->Names.Count);
+    InitBitSet(&Network->EndsInZ, Network->Names.Count);
+    for(aoc_index Node = 0; Node < Network->Names.Count; Node++)
+    {
+        char C = LastChar(Network->Names.Elements[Node]);
+        if(C == 'A') BitSetSet(&Network->EndsInA, Node);
+        if(C == 'Z') BitSetSet(&Network->EndsInZ, Node);
     }
+}
+
+static void FreeNetwork(network* Network)
+{
+    FreeInsArray(&Network->Ins);
+    FreeNodeArray(&Network->Names);
+    FreeBitSet(&Network->EndsInA);
+    FreeBitSet(&Network->EndsInZ);
+}
 
-    // Follow the instructions and count the number of steps.
-    int64_t Steps = 0;
-    uint16_t Curr = MakeNode('A', 'A', 'A');
-    while(Curr != ZZZ)
+// Returns the node with a name, or NO_NODE if there's none.
+static uint16_t FindNode(network* Network, uint16_t Name)
+{
+    for(aoc_index Node = 0; Node < Network->Names.Count; Node++)
     {
-        switch(*At)
+        if(Network->Names.Elements[Node] == Name) return (uint16_t)Node;
+    }
+    return NO_NODE;
+}
+
+ARRAY(step_array, StepArray, int64_t)
+
+// Jump tables for following the instructions a whole pass at a time. A pass
+// from each node ends on Jumps[0], and lands on targets at the steps from
+// TargetBegin up to TargetEnd in TargetSteps. Level K jumps 2^K passes, and
+// Reaches notes if a target was landed on during them.
+#define JUMP_LEVELS (17)
+
+typedef struct
+{
+    int LevelCount;
+    uint16_t* Jumps[JUMP_LEVELS];
+    bool* Reaches[JUMP_LEVELS];
+    step_array TargetSteps;
+    aoc_index* TargetBegin;
+    aoc_index* TargetEnd;
+} jump_table;
+
+static void InitJumpTable(jump_table* Table, network* Network, const bit_set* Targets)
+{
+    // A walk that lands on no target in as many passes as there are nodes is
+    // stuck in a loop, so no longer jumps are needed.
+    Table->LevelCount = 1;
+    aoc_index NodeCount = Network->Names.Count;
+    while(Table->LevelCount < JUMP_LEVELS && ((aoc_index)1 << Table->LevelCount) <= NodeCount)
+    {
+        Table->LevelCount++;
+    }
+    for(int Level = 0; Level < Table->LevelCount; Level++)
+    {
+        Table->Jumps[Level] = (uint16_t*)malloc(sizeof(uint16_t) * NodeCount);
+        Table->Reaches[Level] = (bool*)malloc(sizeof(bool) * NodeCount);
+    }
+    InitStepArray(&Table->TargetSteps);
+    Table->TargetBegin = (aoc_index*)malloc(sizeof(aoc_index) * NodeCount);
+    Table->TargetEnd = (aoc_index*)malloc(sizeof(aoc_index) * NodeCount);
+
+    // Follow one pass from each node.
+    const ins* Ins = Network->Ins.Elements;
+    for(aoc_index Start = 0; Start < NodeCount; Start++)
+    {
+        uint16_t Node = (uint16_t)Start;
+        Table->TargetBegin[Start] = Table->TargetSteps.Count;
+        for(int64_t Step = 0; Step < Network->InstructionCount; Step++)
         {
-        case 'L':
-            Curr = Ins[Curr].Left;
-            break;
-        case 'R':
-            Curr = Ins[Curr].Right;
-            break;
-        default:
-            At = Input;
-            continue;
+            Node = Network->Instructions[Step] == 'L' ? Ins[Node].Left : Ins[Node].Right;
+            if(BitSetContains(Targets, Node)) StepArrayAdd(&Table->TargetSteps, Step + 1);
         }
-        Steps++;
-        At++;
+        Table->TargetEnd[Start] = Table->TargetSteps.Count;
+        Table->Jumps[0][Start] = Node;
+        Table->Reaches[0][Start] = Table->TargetBegin[Start] < Table->TargetEnd[Start];
     }
 
-    free(Ins);
-    return Steps;
+    // Each level is two jumps of the level below.
+    for(int Level = 1; Level < Table->LevelCount; Level++)
+    {
+        uint16_t* Jumps = Table->Jumps[Level - 1];
+        bool* Reaches = Table->Reaches[Level - 1];
+        for(aoc_index Node = 0; Node < NodeCount; Node++)
+        {
+            uint16_t Middle = Jumps[Node];
+            Table->Jumps[Level][Node] = Jumps[Middle];
+            Table->Reaches[Level][Node] = Reaches[Node] || Reaches[Middle];
+        }
+    }
 }
 
-static char LastChar(uint16_t Node)
+static void FreeJumpTable(jump_table* Table)
 {
-    // Each char takes up 5 bits. 31 = 0b11111 to mask off the last char's offset.
-    return 'A' + (Node & 31);
+    for(int Level = 0; Level < Table->LevelCount; Level++)
+    {
+        free(Table->Jumps[Level]);
+        free(Table->Reaches[Level]);
+    }
+    FreeStepArray(&Table->TargetSteps);
+    free(Table->TargetBegin);
+    free(Table->TargetEnd);
+}
+
+// Counts the steps from Start until landing on a target, or returns -1 if
+// that never happens. Whole passes are skipped for as long as they land on
+// no target, from the longest jump down.
+static int64_t StepsToTarget(jump_table* Table, network* Network, const bit_set* Targets, uint16_t Start)
+{
+    if(BitSetContains(Targets, Start)) return 0;
+    int64_t Passes = 0;
+    uint16_t Node = Start;
+    for(int Level = Table->LevelCount - 1; Level >= 0; Level--)
+    {
+        if(Table->Reaches[Level][Node]) continue;
+        Node = Table->Jumps[Level][Node];
+        Passes += (int64_t)1 << Level;
+    }
+    if(!Table->Reaches[0][Node]) return -1;
+    int64_t FirstTarget = Table->TargetSteps.Elements[Table->TargetBegin[Node]];
+    return AocAdd(AocMul(Passes, Network->InstructionCount), FirstTarget);
+}
+
+AOC_SOLVER(Part1)
+{
+    network Network;
+    ParseNetwork(&Network, Input);
+    uint16_t Start = FindNode(&Network, MakeNode('A', 'A', 'A'));
+    uint16_t End = FindNode(&Network, MakeNode('Z', 'Z', 'Z'));
+    if(Start == NO_NODE || End == NO_NODE)
+    {
+        FreeNetwork(&Network);
+        return -1;
+    }
+    bit_set Targets;
+    InitBitSet(&Targets, Network.Names.Count);
+    BitSetSet(&Targets, End);
+
+    jump_table Table;
+    InitJumpTable(&Table, &Network, &Targets);
+    int64_t Steps = StepsToTarget(&Table, &Network, &Targets, Start);
+
+    FreeJumpTable(&Table);
+    FreeBitSet(&Targets);
+    FreeNetwork(&Network);
+    return Steps;
 }
 
 static int64_t GCD(int64_t A, int64_t B)
@@ -84,69 +256,230 @@ static int64_t GCD(int64_t A, int64_t B)
     return A;
 }
 
-static int64_t LCM(int64_t A, int64_t B)
+// Finds the inverse of A modulo M, where A and M are coprime.
+static int64_t Inverse(int64_t A, int64_t M)
 {
-    return (A * B) / GCD(A, B);
+    int64_t R0 = M, R1 = A % M;
+    int64_t T0 = 0, T1 = 1;
+    while(R1)
+    {
+        int64_t Quotient = R0 / R1;
+        int64_t Temp = R0 - Quotient * R1;
+        R0 = R1;
+        R1 = Temp;
+        Temp = T0 - Quotient * T1;
+        T0 = T1;
+        T1 = Temp;
+    }
+    return T0 < 0 ? T0 + M : T0;
 }
 
-AOC_SOLVER(Part2)
+__extension__ typedef unsigned __int128 uint128;
+
+// Multiplies A and B modulo M, reducing the 128-bit product one bit at a time
+// so no 128-bit division is needed.
+static int64_t MulMod(int64_t A, int64_t B, int64_t M)
 {
-    // Parse the map and detect the ghosts (oooOOOoooOOOOoo).
-    uint16_t ZZZ = MakeNode('Z', 'Z', 'Z');
-    ins* Ins = (ins*)calloc(ZZZ + 1, sizeof(ins));
-    uint16_t* Ghosts = NULL;
-    size_t GhostCount = 0;
-    size_t GhostCapacity = 0;
-    const char* At = SkipPastLine(Input);
-    At = SkipPastLine(At);
-    while(IsUpper(*At))
+    uint128 Product = (uint128)A * (uint64_t)B;
+    uint64_t Remainder = 0;
+    for(int Bit = 127; Bit >= 0; Bit--)
     {
-        uint16_t Node, Left, Right;
-        At = ParseNode(At, &Node) + 4;
-        At = ParseNode(At, &Left) + 2;
-        At = ParseNode(At, &Right) + 1;
-        At = SkipPastNewline(At);
-        Ins[Node] = (ins){.Left = Left, .Right = Right};
-        if(LastChar(Node) == 'A')
+        Remainder = (Remainder << 1) | (uint64_t)((Product >> Bit) & 1);
+        if(Remainder >= (uint64_t)M) Remainder -= M;
+    }
+    return (int64_t)Remainder;
+}
+
+// Combines X = A (mod M) and X = B (mod N) into X = *OutX (mod *OutM), by the
+// Chinese remainder theorem generalised to moduli that aren't coprime.
+// Returns false if there's no such X.
+static bool CombineResidues(int64_t A, int64_t M, int64_t B, int64_t N, int64_t* OutX, int64_t* OutM)
+{
+    int64_t Divisor = GCD(M, N);
+    if((B - A) % Divisor) return false;
+    int64_t Modulus = N / Divisor;
+    int64_t Lcm = AocMul(M / Divisor, N);
+
+    // X = A + M * K, where M / Divisor * K = (B - A) / Divisor (mod Modulus).
+    int64_t Difference = (B - A) / Divisor % Modulus;
+    if(Difference < 0) Difference += Modulus;
+    int64_t K = MulMod(Difference, Inverse(M / Divisor % Modulus, Modulus), Modulus);
+    *OutX = A + M * K;
+    *OutM = Lcm;
+    return true;
+}
+
+// The steps at which a ghost is on a target. A ghost's pass starts repeat
+// after Transient passes, from when it lands on targets every Period steps,
+// with the residues Residues. Earlier targets are at Steps, which are all less
+// than Threshold.
+typedef struct
+{
+    step_array Steps;
+    step_array Residues;
+    int64_t Period;
+    int64_t Threshold;
+} ghost;
+
+static int CompareSteps(const void* A, const void* B)
+{
+    int64_t StepA = *(const int64_t*)A;
+    int64_t StepB = *(const int64_t*)B;
+    return (StepA > StepB) - (StepA < StepB);
+}
+
+// Follows a ghost pass by pass until a pass starts on a node it already
+// started on, noting the steps of the targets on the way.
+static void InitGhost(ghost* Ghost, jump_table* Table, network* Network, int64_t* PassOfNode, uint16_t Start)
+{
+    InitStepArray(&Ghost->Steps);
+    InitStepArray(&Ghost->Residues);
+    if(BitSetContains(&Network->EndsInZ, Start)) StepArrayAdd(&Ghost->Steps, 0);
+    int64_t Length = Network->InstructionCount;
+    int64_t Pass = 0;
+    uint16_t Node = Start;
+    while(PassOfNode[Node] < 0)
+    {
+        PassOfNode[Node] = Pass;
+        for(aoc_index Index = Table->TargetBegin[Node]; Index < Table->TargetEnd[Node]; Index++)
         {
-            if(GhostCount == GhostCapacity)
+            StepArrayAdd(&Ghost->Steps, Pass * Length + Table->TargetSteps.Elements[Index]);
+        }
+        Node = Table->Jumps[0][Node];
+        Pass++;
+    }
+    int64_t Transient = PassOfNode[Node];
+    Ghost->Period = (Pass - Transient) * Length;
+    Ghost->Threshold = Transient * Length + 1;
+
+    // Reset the passes for the next ghost.
+    for(uint16_t Reset = Start; PassOfNode[Reset] >= 0; Reset = Table->Jumps[0][Reset])
+    {
+        PassOfNode[Reset] = -1;
+    }
+
+    // Split off the targets in the cycle.
+    aoc_index Count = 0;
+    for(aoc_index Index = 0; Index < Ghost->Steps.Count; Index++)
+    {
+        int64_t Step = Ghost->Steps.Elements[Index];
+        if(Step < Ghost->Threshold) Ghost->Steps.Elements[Count++] = Step;
+        else StepArrayAdd(&Ghost->Residues, Step % Ghost->Period);
+    }
+    Ghost->Steps.Count = Count;
+    qsort(Ghost->Residues.Elements, Ghost->Residues.Count, sizeof(int64_t), CompareSteps);
+}
+
+static void FreeGhost(ghost* Ghost)
+{
+    FreeStepArray(&Ghost->Steps);
+    FreeStepArray(&Ghost->Residues);
+}
+
+static bool GhostOnTarget(ghost* Ghost, int64_t Step)
+{
+    if(Step >= Ghost->Threshold)
+    {
+        int64_t Residue = Step % Ghost->Period;
+        return bsearch(&Residue, Ghost->Residues.Elements, Ghost->Residues.Count, sizeof(int64_t), CompareSteps) != NULL;
+    }
+    return bsearch(&Step, Ghost->Steps.Elements, Ghost->Steps.Count, sizeof(int64_t), CompareSteps) != NULL;
+}
+
+SMALL_ARRAY(ghost_array, GhostArray, ghost, 16)
+
+// Finds the first step on which every ghost is on a target. A step before
+// some ghost's cycle is one of that ghost's early steps, so those are checked
+// directly. Later steps are in every cycle, so the cycles' residues are
+// combined and the first step past every threshold is taken.
+static int64_t StepsToAllTargets(ghost_array* Ghosts)
+{
+    int64_t Best = -1;
+    for(aoc_index GhostIndex = 0; GhostIndex < Ghosts->Count; GhostIndex++)
+    {
+        step_array* Steps = &Ghosts->Elements[GhostIndex].Steps;
+        for(aoc_index Index = 0; Index < Steps->Count; Index++)
+        {
+            int64_t Step = Steps->Elements[Index];
+            if(Best >= 0 && Step >= Best) break;
+            bool AllOnTarget = true;
+            for(aoc_index Other = 0; Other < Ghosts->Count && AllOnTarget; Other++)
             {
-                GhostCapacity = GhostCapacity ? 2 * GhostCapacity : 8;
-                Ghosts = (uint16_t*)realloc(Ghosts, GhostCapacity);
+                AllOnTarget = GhostOnTarget(&Ghosts->Elements[Other], Step);
             }
-            Ghosts[GhostCount++] = Node;
+            if(AllOnTarget) Best = Step;
         }
     }
+    if(Best >= 0) return Best;
 
-    // Compute the lowest common multiple of the steps taken for each ghost
-    // to reach a node ending in 'Z', to work out the number of steps it will
-    // take for every ghost to be on a node ending in 'Z'.
-    int64_t OverallSteps;
-    for(int GhostIndex = 0; GhostIndex < GhostCount; GhostIndex++)
+    step_array Residues, Combined;
+    InitStepArray(&Residues);
+    InitStepArray(&Combined);
+    StepArrayAdd(&Residues, 0);
+    int64_t Period = 1;
+    int64_t Threshold = 0;
+    for(aoc_index GhostIndex = 0; GhostIndex < Ghosts->Count; GhostIndex++)
     {
-        int64_t Steps = 0;
-        uint16_t Ghost = Ghosts[GhostIndex];
-        while(LastChar(Ghost) != 'Z')
+        ghost* Ghost = &Ghosts->Elements[GhostIndex];
+        if(Ghost->Threshold > Threshold) Threshold = Ghost->Threshold;
+        int64_t CombinedPeriod = Period;
+        StepArrayReset(&Combined);
+        for(aoc_index Index = 0; Index < Residues.Count; Index++)
         {
-            switch(*At)
+            for(aoc_index GhostResidue = 0; GhostResidue < Ghost->Residues.Count; GhostResidue++)
             {
-            case 'L':
-                Ghost = Ins[Ghost].Left;
-                break;
-            case 'R':
-                Ghost = Ins[Ghost].Right;
-                break;
-            default:
-                At = Input;
-                continue;
+                int64_t Residue;
+                if(CombineResidues(Residues.Elements[Index], Period, Ghost->Residues.Elements[GhostResidue],
+                                   Ghost->Period, &Residue, &CombinedPeriod))
+                {
+                    StepArrayAdd(&Combined, Residue);
+                }
             }
-            Steps++;
-            At++;
         }
-        OverallSteps = GhostIndex ? LCM(Steps, OverallSteps) : Steps;
+        StepArraySwap(&Residues, &Combined);
+        Period = CombinedPeriod;
     }
 
-    free(Ghosts);
-    free(Ins);
-    return OverallSteps;
+    for(aoc_index Index = 0; Index < Residues.Count; Index++)
+    {
+        int64_t Step = Residues.Elements[Index];
+        if(Step < Threshold) Step = AocAdd(Step, AocMul((Threshold - Step + Period - 1) / Period, Period));
+        if(Best < 0 || Step < Best) Best = Step;
+    }
+    FreeStepArray(&Residues);
+    FreeStepArray(&Combined);
+    return Best;
+}
+
+AOC_SOLVER(Part2)
+{
+    // Parse the map and detect the ghosts (oooOOOoooOOOOoo).
+    network Network;
+    ParseNetwork(&Network, Input);
+    jump_table Table;
+    InitJumpTable(&Table, &Network, &Network.EndsInZ);
+
+    // Find where each ghost lands on targets, then when they all do at once.
+    int64_t* PassOfNode = (int64_t*)malloc(sizeof(int64_t) * Network.Names.Count);
+    for(aoc_index Node = 0; Node < Network.Names.Count; Node++)
+    {
+        PassOfNode[Node] = -1;
+    }
+    ghost_array Ghosts;
+    InitGhostArray(&Ghosts);
+    for(size_t Node = BitSetNext(&Network.EndsInA, 0); Node < Network.EndsInA.BitCount; Node = BitSetNext(&Network.EndsInA, Node + 1))
+    {
+        InitGhost(GhostArrayPush(&Ghosts), &Table, &Network, PassOfNode, (uint16_t)Node);
+    }
+    int64_t Steps = Ghosts.Count ? StepsToAllTargets(&Ghosts) : -1;
+
+    for(aoc_index Index = 0; Index < Ghosts.Count; Index++)
+    {
+        FreeGhost(&Ghosts.Elements[Index]);
+    }
+    FreeGhostArray(&Ghosts);
+    free(PassOfNode);
+    FreeJumpTable(&Table);
+    FreeNetwork(&Network);
+    return Steps;
 }
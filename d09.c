@@ -1,118 +1,177 @@
 #include "aoc.h"
+#include "array.h"
 #include "parse.h"
 
+#include <immintrin.h>
+
 const char* DefaultInputPath = "d09.txt";
 
-typedef struct
-{
-    int64_t* Elements;
-    size_t Count;
-    size_t Capacity;
-} sequence;
+ARRAY(value_array, ValueArray, int64_t)
+
+__extension__ typedef __int128 int128;
 
-static void InitSequence(sequence* Sequence)
+static bool IsNumeric(char C)
 {
-    Sequence->Elements = NULL;
-    Sequence->Count = 0;
-    Sequence->Capacity = 0;
+    return IsDigit(C) || C == '-';
 }
 
-static void FreeSequence(sequence* Sequence)
+static inline const char* SkipPastNumeric(const char* Input)
 {
-    free(Sequence->Elements);
-    InitSequence(Sequence);
+    while(IsNumeric(*Input)) Input++;
+    return Input;
 }
 
-static void SequenceAdd(sequence* Sequence, int64_t Element)
+// Extrapolates a sequence by reducing it to zero. Going forwards, the end of
+// each step is added. (As they will sum the next number in the sequence.)
+// Going backwards, the start of each step is added and subtracted in turn.
+// Steps are exact in 128 bits, so only an answer that doesn't fit in 64 bits
+// overflows.
+static int64_t ExtrapolateByDifferences(const int64_t* Values, int Count, bool Reverse)
 {
-    size_t Capacity = Sequence->Capacity;
-    if(Sequence->Count == Capacity)
+    int128* Steps = (int128*)malloc(sizeof(int128) * (Count + 1));
+    bool IsZero = true;
+    for(int Index = 0; Index < Count; Index++)
     {
-        Capacity = Capacity ? 2 * Capacity : 8;
-        Sequence->Elements = (int64_t*)realloc(Sequence->Elements, sizeof(int64_t) * Capacity);
-        Sequence->Capacity = Capacity;
+        Steps[Index] = Values[Index];
+        IsZero = IsZero && !Values[Index];
     }
-    Sequence->Elements[Sequence->Count++] = Element;
-}
 
-static void SequenceReset(sequence* Sequence)
-{
-    Sequence->Count = 0;
-}
-
-static void SequenceReverse(sequence* Sequence)
-{
-    size_t Count = Sequence->Count;
-    size_t HalfCount = Count / 2;
-    for(int Index = 0; Index < HalfCount; Index++)
+    int128 Next = 0;
+    bool Negate = false;
+    bool Overflow = false;
+    for(; Count > 0 && !IsZero; Count--)
     {
-        int ReverseIndex = Count - Index - 1;
-        int64_t Temp = Sequence->Elements[Index];
-        Sequence->Elements[Index] = Sequence->Elements[ReverseIndex];
-        Sequence->Elements[ReverseIndex] = Temp;
+        int128 Term = Reverse ? (Negate ? -Steps[0] : Steps[0]) : Steps[Count - 1];
+        Overflow |= __builtin_add_overflow(Next, Term, &Next);
+        Negate = !Negate;
+        IsZero = true;
+        for(int Index = 1; Index < Count; Index++)
+        {
+            Overflow |= __builtin_sub_overflow(Steps[Index], Steps[Index - 1], &Steps[Index - 1]);
+            IsZero = IsZero && !Steps[Index - 1];
+        }
     }
+    free(Steps);
+    if(Overflow || Next < INT64_MIN || Next > INT64_MAX) AocOverflow();
+    return (int64_t)Next;
 }
 
-static bool SequenceIsZero(sequence* Sequence)
+// Reducing a sequence of N values to zero extrapolates it with a polynomial,
+// which is a fixed weighting of its values. The next value is the sum of
+// (-1)^(N - 1 - I) * C(N, I) times each value I, and the value before the first
+// is the sum of (-1)^I * C(N, I + 1) times each value I. Weights are computed
+// modulo 2^64, which gives exact sums whenever they fit in 64 bits.
+static uint64_t* MakeWeights(int Count, bool Reverse)
 {
-    for(int Index = 0; Index < Sequence->Count; Index++)
+    uint64_t* Binomials = (uint64_t*)calloc(Count + 1, sizeof(uint64_t));
+    Binomials[0] = 1;
+    for(int Row = 1; Row <= Count; Row++)
     {
-        if(Sequence->Elements[Index])
+        for(int Index = Row; Index > 0; Index--)
         {
-            return false;
+            Binomials[Index] += Binomials[Index - 1];
         }
     }
-    return true;
+    uint64_t* Weights = (uint64_t*)malloc(sizeof(uint64_t) * Count);
+    for(int Index = 0; Index < Count; Index++)
+    {
+        uint64_t Weight = Reverse ? Binomials[Index + 1] : Binomials[Index];
+        bool Negative = Reverse ? Index % 2 : (Count - 1 - Index) % 2;
+        Weights[Index] = Negative ? 0 - Weight : Weight;
+    }
+    free(Binomials);
+    return Weights;
 }
 
-static bool IsNumeric(char C)
+// Multiplies 64-bit lanes, keeping the low 64 bits of each product.
+static __m256i MulLo64(__m256i A, __m256i B)
 {
-    return IsDigit(C) || C == '-';
+    __m256i Low = _mm256_mul_epu32(A, B);
+    __m256i Cross = _mm256_add_epi64(
+        _mm256_mul_epu32(_mm256_srli_epi64(A, 32), B),
+        _mm256_mul_epu32(A, _mm256_srli_epi64(B, 32)));
+    return _mm256_add_epi64(Low, _mm256_slli_epi64(Cross, 32));
 }
 
-static inline const char* SkipPastNumeric(const char* Input)
+static int64_t SumWeighted(const int64_t* Values, const uint64_t* Weights, int Count)
 {
-    while(IsNumeric(*Input)) Input++;
-    return Input;
+    __m256i Sum = _mm256_setzero_si256();
+    int Index = 0;
+    for(; Index + 4 <= Count; Index += 4)
+    {
+        __m256i Value = _mm256_loadu_si256((const __m256i*)(Values + Index));
+        __m256i Weight = _mm256_loadu_si256((const __m256i*)(Weights + Index));
+        Sum = _mm256_add_epi64(Sum, MulLo64(Value, Weight));
+    }
+    __m128i Half = _mm_add_epi64(_mm256_castsi256_si128(Sum), _mm256_extracti128_si256(Sum, 1));
+    uint64_t Total = (uint64_t)_mm_cvtsi128_si64(Half) + (uint64_t)_mm_extract_epi64(Half, 1);
+    for(; Index < Count; Index++)
+    {
+        Total += (uint64_t)Values[Index] * Weights[Index];
+    }
+    return (int64_t)Total;
+}
+
+// The weights of N values add up to at most 2^N in size, so when the values
+// are small enough the weighted sum fits in 64 bits and is exact. Otherwise
+// the sequence is reduced in 128 bits.
+static int64_t Extrapolate(const int64_t* Values, const uint64_t* Weights, int Count, bool Reverse)
+{
+    uint64_t Largest = 0;
+    for(int Index = 0; Index < Count; Index++)
+    {
+        int64_t Value = Values[Index];
+        Largest |= Value < 0 ? 0 - (uint64_t)Value : (uint64_t)Value;
+    }
+    if(Count < 62 && Largest < (UINT64_C(1) << (62 - Count)))
+    {
+        return SumWeighted(Values, Weights, Count);
+    }
+    return ExtrapolateByDifferences(Values, Count, Reverse);
 }
 
 int64_t Solve(const char* Input, bool Reverse)
 {
+    // Parse the sequences one after another into a single buffer of rows.
+    // Sequences are usually all as long as the first, so its weights are made
+    // once. Any others are reduced on their own and dropped from the buffer.
     int64_t Sum = 0;
-    sequence Sequence;
-    InitSequence(&Sequence);
+    value_array Values;
+    InitValueArray(&Values);
+    ValueArrayReserve(&Values, strlen(Input) / 2 + 1);
+    int Length = -1;
+    uint64_t* Weights = NULL;
     while(IsNumeric(*Input))
     {
-        // Parse the sequence.
+        size_t RowStart = Values.Count;
         while(IsNumeric(*Input))
         {
-            SequenceAdd(&Sequence, atoll(Input));
+            ValueArrayAdd(&Values, atoll(Input));
             Input = SkipPastNumeric(Input);
             Input = SkipPastWhitespace(Input);
         }
         Input = SkipPastNewline(Input);
 
-        // Reverse the sequence if extrapolating backwards.
-        if(Reverse)
+        int Count = (int)(Values.Count - RowStart);
+        if(Length < 0)
         {
-            SequenceReverse(&Sequence);
+            Length = Count;
+            Weights = MakeWeights(Length, Reverse);
         }
-
-        // Reduce the sequence to zero, adding the end of each step to the sum.
-        // (As they will sum the next number in the sequence.)
-        while(!SequenceIsZero(&Sequence))
+        if(Count != Length)
         {
-            Sum += Sequence.Elements[Sequence.Count - 1];
-            for(int Index = 1; Index < Sequence.Count; Index++)
-            {
-                Sequence.Elements[Index - 1] = Sequence.Elements[Index] - Sequence.Elements[Index - 1];
-            }
-            Sequence.Count--;
+            Sum = AocAdd(Sum, ExtrapolateByDifferences(Values.Elements + RowStart, Count, Reverse));
+            Values.Count = RowStart;
         }
+    }
 
-        SequenceReset(&Sequence);
+    for(size_t RowStart = 0; RowStart < Values.Count; RowStart += Length)
+    {
+        Sum = AocAdd(Sum, Extrapolate(Values.Elements + RowStart, Weights, Length, Reverse));
     }
-    FreeSequence(&Sequence);
+
+    free(Weights);
+    FreeValueArray(&Values);
     return Sum;
 }
 
@@ -1,4 +1,5 @@
 #include "aoc.h"
+#include "bitset.h"
 #include "parse.h"
 
 const char* DefaultInputPath = "d11.txt";
@@ -24,26 +25,6 @@ static const char* SkipPastEmpty(const char* Input)
     return Input;
 }
 
-typedef struct
-{
-    uint64_t Bits[3];
-} bit_set;
-
-static void InitBitSet(bit_set* Set, uint8_t Byte)
-{
-    memset(Set, Byte, sizeof(bit_set));
-}
-
-static void BitSetClear(bit_set* Set, uint64_t Index)
-{
-    Set->Bits[Index / 64llu] &= ~(1llu << (Index % 64llu));
-}
-
-static bool BitSetContains(bit_set* Set, uint64_t Index)
-{
-    return (Set->Bits[Index / 64llu] & (1llu << (Index % 64llu))) != 0;
-}
-
 typedef struct
 {
     int64_t X;
@@ -52,17 +33,26 @@ typedef struct
 
 static int64_t Solve(const char* Input, int64_t Expansion)
 {
+    // Size the row and column sets from the width of the first row. Every row
+    // but the last is followed by at least one newline character.
+    const char* At = Input;
+    while(IsImage(*At)) At++;
+    size_t Width = At - Input;
+    size_t MaxHeight = (strlen(Input) + 1) / (Width + 1);
+    bit_set EmptyRows, EmptyCols;
+    InitBitSet(&EmptyRows, MaxHeight);
+    InitBitSet(&EmptyCols, Width);
+    BitSetFill(&EmptyRows, true);
+    BitSetFill(&EmptyCols, true);
+
     // Scan the input, to determine which rows are empty and which contain
     // galaxies.
-    bit_set EmptyRows, EmptyCols;
-    InitBitSet(&EmptyRows, 0xFF);
-    InitBitSet(&EmptyCols, 0xFF);
-    int GalaxyCount = 0;
-    const char* At = Input;
-    int Row = 0;
+    aoc_index GalaxyCount = 0;
+    At = Input;
+    aoc_index Row = 0;
     while(IsImage(*At))
     {
-        int Col = 0;
+        aoc_index Col = 0;
         while(IsImage(*At))
         {
             if(IsGalaxy(*At))
@@ -94,7 +84,7 @@ static int64_t Solve(const char* Input, int64_t Expansion)
         }
         else
         {
-            int Col = 0;
+            aoc_index Col = 0;
             int64_t ExpandedCol = 0;
             while(IsImage(*At))
             {
@@ -120,18 +110,20 @@ static int64_t Solve(const char* Input, int64_t Expansion)
     }
 
     // Calculate the manhattan distance between galaxies.
-    uint64_t Sum = 0;
-    for(int FromIndex = 0; FromIndex < GalaxyCount; FromIndex++)
+    int64_t Sum = 0;
+    for(aoc_index FromIndex = 0; FromIndex < GalaxyCount; FromIndex++)
     {
         ivec2 From = Galaxies[FromIndex];
-        for(int ToIndex = FromIndex + 1; ToIndex < GalaxyCount; ToIndex++)
+        for(aoc_index ToIndex = FromIndex + 1; ToIndex < GalaxyCount; ToIndex++)
         {
             ivec2 To = Galaxies[ToIndex];
-            Sum += llabs(To.X - From.X) + llabs(To.Y - From.Y);
+            Sum = AocAdd(Sum, llabs(To.X - From.X) + llabs(To.Y - From.Y));
         }
     }
 
     free(Galaxies);
+    FreeBitSet(&EmptyRows);
+    FreeBitSet(&EmptyCols);
     return Sum;
 }
 
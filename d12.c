@@ -1,4 +1,5 @@
 #include "aoc.h"
+#include "array.h"
 #include "parse.h"
 
 #define XXH_INLINE_ALL
@@ -198,7 +199,7 @@ static int64_t CountArrangements(table* Cache, const char* Record, int Length, i
         }
 
         // We've found a good spot for our group.
-        Arrangements += CountArrangements(Cache, Record, Length, GroupEnd, Groups, GroupCount, GroupIndex + 1, Slack - Offset);
+        Arrangements = AocAdd(Arrangements, CountArrangements(Cache, Record, Length, GroupEnd, Groups, GroupCount, GroupIndex + 1, Slack - Offset));
 
     NextOffset:
         continue;
@@ -207,13 +208,15 @@ static int64_t CountArrangements(table* Cache, const char* Record, int Length, i
     return Arrangements;
 }
 
+SMALL_ARRAY(group_array, GroupArray, int, 32)
+
 static int64_t Solve(const char* Input, int Folds)
 {
     table Cache;
     InitTable(&Cache);
     int64_t Sum = 0;
-    size_t GroupCapacity = 16;
-    int* Groups = (int*)malloc(sizeof(int) * GroupCapacity);
+    group_array Groups;
+    InitGroupArray(&Groups);
     char* UnfoldedRecordBuffer = NULL;
     size_t UnfoldedRecordCapacity = 1;
     while(IsCondition(*Input))
@@ -222,33 +225,25 @@ static int64_t Solve(const char* Input, int Folds)
         Input = SkipPastConditions(Input);
         int Length = Input - Record;
         Input++;
-        size_t GroupCount = 0;
+        GroupArrayReset(&Groups);
         int NumBroken = 0;
         while(IsDigit(*Input))
         {
-            if(GroupCount == GroupCapacity)
-            {
-                GroupCapacity *= 2;
-                Groups = (int*)realloc(Groups, sizeof(int) * GroupCapacity);
-            }
             int Group = atoi(Input);
-            Groups[GroupCount++] = Group;
+            GroupArrayAdd(&Groups, Group);
             Input = SkipPastDigits(Input);
             NumBroken += Group;
             if(*Input == ',') Input++;
         }
+        size_t GroupCount = Groups.Count;
         if(Folds > 1)
         {
             // Unfold the groups.
             size_t UnfoldedGroupCount = GroupCount * Folds;
-            while(GroupCapacity < UnfoldedGroupCount)
-            {
-                GroupCapacity *= 2;
-                Groups = (int*)realloc(Groups, sizeof(int) * GroupCapacity);
-            }
+            GroupArrayReserve(&Groups, UnfoldedGroupCount);
             for(int Index = GroupCount; Index < UnfoldedGroupCount; Index += GroupCount)
             {
-                memcpy(&Groups[Index], Groups, sizeof(int) * GroupCount);
+                memcpy(&Groups.Elements[Index], Groups.Elements, sizeof(int) * GroupCount);
             }
             GroupCount = UnfoldedGroupCount;
             NumBroken *= Folds;
@@ -275,12 +270,12 @@ static int64_t Solve(const char* Input, int Folds)
             Length = UnfoldedRecordLength;
         }
         int Slack = Length - (NumBroken + GroupCount - 1);
-        Sum += CountArrangements(&Cache, Record, Length, 0, Groups, GroupCount, 0, Slack);
+        Sum = AocAdd(Sum, CountArrangements(&Cache, Record, Length, 0, Groups.Elements, GroupCount, 0, Slack));
         Input = SkipPastNewline(Input);
         TableReset(&Cache);
     }
     free(UnfoldedRecordBuffer);
-    free(Groups);
+    FreeGroupArray(&Groups);
     FreeTable(&Cache);
     return Sum;
 }
@@ -1,4 +1,5 @@
 #include "aoc.h"
+#include "array.h"
 #include "parse.h"
 
 const char* DefaultInputPath = "d13.txt";
@@ -18,41 +19,7 @@ static bool IsPattern(char C)
     return IsAsh(C) || IsRock(C);
 }
 
-typedef struct
-{
-    uint32_t* Elements;
-    size_t Count;
-    size_t Capacity;
-} slice_array;
-
-static void InitSliceArray(slice_array* Array)
-{
-    Array->Elements = NULL;
-    Array->Count = 0;
-    Array->Capacity = 0;
-}
-
-static void FreeSliceArray(slice_array* Array)
-{
-    free(Array->Elements);
-}
-
-static void SliceArrayAdd(slice_array* Array, uint32_t Element)
-{
-    size_t Capacity = Array->Capacity;
-    if(Array->Count == Capacity)
-    {
-        Capacity = Capacity ? 2 * Capacity : 8;
-        Array->Elements = (uint32_t*)realloc(Array->Elements, sizeof(uint32_t) * Capacity);
-        Array->Capacity = Capacity;
-    }
-    Array->Elements[Array->Count++] = Element;
-}
-
-static void SliceArrayReset(slice_array* Array)
-{
-    Array->Count = 0;
-}
+SMALL_ARRAY(slice_array, SliceArray, uint32_t, 32)
 
 typedef int (*check_reflection_fn)(slice_array* Slices, int Width);
 
@@ -31,8 +31,8 @@ typedef struct
     size_t Capacity;
     size_t Count;
     char* Cells;
-    int Width;
-    int Height;
+    aoc_index Width;
+    aoc_index Height;
 } grid;
 
 static void InitGrid(grid* Grid, const char* Input)
@@ -58,20 +58,20 @@ static void InitGrid(grid* Grid, const char* Input)
     Grid->Width = Grid->Count / Grid->Height;
 }
 
-static inline int GridIndex(grid* Grid, int X, int Y)
+static inline aoc_index GridIndex(grid* Grid, aoc_index X, aoc_index Y)
 {
     return X + Grid->Width * Y;
 }
 
 static void GridRollNorth(grid* Grid)
 {
-    int Index = 0;
-    for(int Y = 0; Y < Grid->Height; Y++)
+    aoc_index Index = 0;
+    for(aoc_index Y = 0; Y < Grid->Height; Y++)
     {
-        for(int X = 0; X < Grid->Width; X++, Index++)
+        for(aoc_index X = 0; X < Grid->Width; X++, Index++)
         {
             if(!IsRound(Grid->Cells[Index])) continue;
-            int MoveIndex = Index;
+            aoc_index MoveIndex = Index;
             while(MoveIndex >= Grid->Width && IsEmpty(Grid->Cells[MoveIndex - Grid->Width]))
             {
                 MoveIndex -= Grid->Width;
@@ -87,14 +87,14 @@ static void GridRollNorth(grid* Grid)
 
 static void GridRollEast(grid* Grid)
 {
-    for(int Y = 0; Y < Grid->Height; Y++)
+    for(aoc_index Y = 0; Y < Grid->Height; Y++)
     {
-        for(int X = Grid->Width - 1; X >= 0; X--)
+        for(aoc_index X = Grid->Width - 1; X >= 0; X--)
         {
-            int Index = GridIndex(Grid, X, Y);
+            aoc_index Index = GridIndex(Grid, X, Y);
             if(!IsRound(Grid->Cells[Index])) continue;
-            int MoveX = X;
-            int MoveIndex = Index;
+            aoc_index MoveX = X;
+            aoc_index MoveIndex = Index;
             while(MoveX < Grid->Width - 1 && IsEmpty(Grid->Cells[MoveIndex + 1]))
             {
                 MoveX++;
@@ -111,14 +111,14 @@ static void GridRollEast(grid* Grid)
 
 static void GridRollSouth(grid* Grid)
 {
-    for(int Y = Grid->Height - 1; Y >= 0; Y--)
+    for(aoc_index Y = Grid->Height - 1; Y >= 0; Y--)
     {
-        for(int X = 0; X < Grid->Width; X++)
+        for(aoc_index X = 0; X < Grid->Width; X++)
         {
-            int Index = GridIndex(Grid, X, Y);
+            aoc_index Index = GridIndex(Grid, X, Y);
             if(!IsRound(Grid->Cells[Index])) continue;
-            int MoveY = Y;
-            int MoveIndex = Index;
+            aoc_index MoveY = Y;
+            aoc_index MoveIndex = Index;
             while(MoveY < Grid->Height - 1 && IsEmpty(Grid->Cells[MoveIndex + Grid->Width]))
             {
                 MoveY++;
@@ -135,14 +135,14 @@ static void GridRollSouth(grid* Grid)
 
 static void GridRollWest(grid* Grid)
 {
-    int Index = 0;
-    for(int Y = 0; Y < Grid->Height; Y++)
+    aoc_index Index = 0;
+    for(aoc_index Y = 0; Y < Grid->Height; Y++)
     {
-        for(int X = 0; X < Grid->Width; X++, Index++)
+        for(aoc_index X = 0; X < Grid->Width; X++, Index++)
         {
             if(!IsRound(Grid->Cells[Index])) continue;
-            int MoveX = X;
-            int MoveIndex = Index;
+            aoc_index MoveX = X;
+            aoc_index MoveIndex = Index;
             while(MoveX > 0 && IsEmpty(Grid->Cells[MoveIndex - 1]))
             {
                 MoveX--;
@@ -168,10 +168,10 @@ static void GridCycle(grid* Grid)
 static int64_t GridTotalLoad(grid* Grid)
 {
     int64_t Sum = 0;
-    int Index = 0;
-    for(int Y = 0; Y < Grid->Height; Y++)
+    aoc_index Index = 0;
+    for(aoc_index Y = 0; Y < Grid->Height; Y++)
     {
-        for(int X = 0; X < Grid->Width; X++, Index++)
+        for(aoc_index X = 0; X < Grid->Width; X++, Index++)
         {
             if(IsRound(Grid->Cells[Index])) Sum += Grid->Height - Y;
         }
@@ -187,10 +187,10 @@ static uint64_t GridHash(grid* Grid)
 #if 0
 static void GridPrint(grid* Grid)
 {
-    int Index = 0;
-    for(int Y = 0; Y < Grid->Height; Y++)
+    aoc_index Index = 0;
+    for(aoc_index Y = 0; Y < Grid->Height; Y++)
     {
-        for(int X = 0; X < Grid->Width; X++, Index++)
+        for(aoc_index X = 0; X < Grid->Width; X++, Index++)
         {
             putchar(Grid->Cells[Index]);
         }
@@ -1,4 +1,5 @@
 #include "aoc.h"
+#include "gen/d15_tables.h"
 #include "parse.h"
 
 const char* DefaultInputPath = "d15.txt";
@@ -21,7 +22,7 @@ AOC_SOLVER(Part1)
         case '\n':
             return Sum + Value;
         default:
-            Value = ((Value + C) * 17) & 255;
+            Value = HashStep[Value][(uint8_t)C];
             break;
         }
     }
@@ -165,7 +166,7 @@ AOC_SOLVER(Part2)
             }
             default:
                 Id = (Id << 8) | C;
-                Hash = ((Hash + C) * 17) & 255;
+                Hash = HashStep[Hash][(uint8_t)C];
                 break;
         }
     }
@@ -1,4 +1,6 @@
 #include "aoc.h"
+#include "array.h"
+#include "bitset.h"
 #include "parse.h"
 
 const char* DefaultInputPath = "d16.txt";
@@ -8,8 +10,8 @@ typedef struct
     size_t Capacity;
     size_t Count;
     char* Cells;
-    int Width;
-    int Height;
+    aoc_index Width;
+    aoc_index Height;
 } grid;
 
 static bool IsGrid(char C)
@@ -56,80 +58,75 @@ enum
     DIR_UP,
     DIR_RIGHT,
     DIR_DOWN,
-    DIR_LEFT
+    DIR_LEFT,
+    NUM_DIRS
 };
 
 typedef struct
 {
-    int X;
-    int Y;
+    aoc_index X;
+    aoc_index Y;
     int Dir;
 } beam;
 
-typedef struct
-{
-    beam* Elements;
-    size_t Count;
-    size_t Capacity;
-} beam_array;
+ARRAY(beam_array, BeamArray, beam)
 
-static void InitBeamArray(beam_array* Array)
-{
-    Array->Elements = NULL;
-    Array->Count = 0;
-    Array->Capacity = 0;
-}
-
-static void FreeBeamArray(beam_array* Array)
+// One set of visited cells per direction, plus one for their union.
+typedef struct
 {
-    free(Array->Elements);
-}
+    bit_set Dirs[NUM_DIRS];
+    bit_set Energized;
+} visited;
 
-static void BeamArrayAdd(beam_array* Array, int X, int Y, int Dir)
+static void InitVisited(visited* Visited, size_t CellCount)
 {
-    size_t Capacity = Array->Capacity;
-    if(Array->Count == Capacity)
+    for(int Dir = 0; Dir < NUM_DIRS; Dir++)
     {
-        Capacity = Capacity ? 2 * Capacity : 8;
-        Array->Elements = (beam*)realloc(Array->Elements, sizeof(beam) * Capacity);
-        Array->Capacity = Capacity;
+        InitBitSet(&Visited->Dirs[Dir], CellCount);
     }
-    Array->Elements[Array->Count++] = (beam){.X = X, .Y = Y, .Dir = Dir};
+    InitBitSet(&Visited->Energized, CellCount);
 }
 
-static beam BeamArrayPop(beam_array* Array)
+static void FreeVisited(visited* Visited)
 {
-    return Array->Elements[--Array->Count];
+    for(int Dir = 0; Dir < NUM_DIRS; Dir++)
+    {
+        FreeBitSet(&Visited->Dirs[Dir]);
+    }
+    FreeBitSet(&Visited->Energized);
 }
 
-static int64_t Simulate(grid* Grid, beam_array* BeamStack, uint8_t* Visited)
+static int64_t Simulate(grid* Grid, beam_array* BeamStack, visited* Visited)
 {
-    memset(Visited, 0, sizeof(uint8_t) * Grid->Count);
+    for(int Dir = 0; Dir < NUM_DIRS; Dir++)
+    {
+        BitSetFill(&Visited->Dirs[Dir], false);
+    }
     while(BeamStack->Count > 0)
     {
         beam Beam = BeamArrayPop(BeamStack);
         if(Beam.X < 0 || Beam.Y < 0) continue;
         if(Beam.X >= Grid->Width || Beam.Y >= Grid->Height) continue;
-        int Index = Beam.Y * Grid->Width + Beam.X;
-        uint8_t DirMask = 1 << Beam.Dir;
-        if(Visited[Index] & DirMask) continue;
-        Visited[Index] |= DirMask;
+        aoc_index Index = Beam.Y * Grid->Width + Beam.X;
+        bit_set* VisitedDir = &Visited->Dirs[Beam.Dir];
+        if(BitSetContains(VisitedDir, Index)) continue;
+        BitSetSet(VisitedDir, Index);
         switch(Grid->Cells[Index])
         {
         case '.':
             switch(Beam.Dir)
             {
             case DIR_UP:
-                BeamArrayAdd(BeamStack, Beam.X, Beam.Y - 1, DIR_UP);
+                BeamArrayAdd(BeamStack, (beam){.X = Beam.X, .Y = Beam.Y - 1, .Dir = DIR_UP});
                 break;
             case DIR_RIGHT:
-                BeamArrayAdd(BeamStack, Beam.X + 1, Beam.Y, DIR_RIGHT);
+                BeamArrayAdd(BeamStack, (beam){.X = Beam.X + 1, .Y = Beam.Y, .Dir = DIR_RIGHT});
                 break;
             case DIR_DOWN:
-                BeamArrayAdd(BeamStack, Beam.X, Beam.Y + 1, DIR_DOWN);
+                BeamArrayAdd(BeamStack, (beam){.X = Beam.X, .Y = Beam.Y + 1, .Dir = DIR_DOWN});
                 break;
             case DIR_LEFT:
-                BeamArrayAdd(BeamStack, Beam.X - 1, Beam.Y, DIR_LEFT);
+                BeamArrayAdd(BeamStack, (beam){.X = Beam.X - 1, .Y = Beam.Y, .Dir = DIR_LEFT});
                 break;
             }
             break;
@@ -137,16 +134,16 @@ static int64_t Simulate(grid* Grid, beam_array* BeamStack, uint8_t* Visited)
             switch(Beam.Dir)
             {
             case DIR_UP:
-                BeamArrayAdd(BeamStack, Beam.X - 1, Beam.Y, DIR_LEFT);
+                BeamArrayAdd(BeamStack, (beam){.X = Beam.X - 1, .Y = Beam.Y, .Dir = DIR_LEFT});
                 break;
             case DIR_RIGHT:
-                BeamArrayAdd(BeamStack, Beam.X, Beam.Y + 1, DIR_DOWN);
+                BeamArrayAdd(BeamStack, (beam){.X = Beam.X, .Y = Beam.Y + 1, .Dir = DIR_DOWN});
                 break;
             case DIR_DOWN:
-                BeamArrayAdd(BeamStack, Beam.X + 1, Beam.Y, DIR_RIGHT);
+                BeamArrayAdd(BeamStack, (beam){.X = Beam.X + 1, .Y = Beam.Y, .Dir = DIR_RIGHT});
                 break;
             case DIR_LEFT:
-                BeamArrayAdd(BeamStack, Beam.X, Beam.Y - 1, DIR_UP);
+                BeamArrayAdd(BeamStack, (beam){.X = Beam.X, .Y = Beam.Y - 1, .Dir = DIR_UP});
                 break;
             }
             break;
@@ -154,16 +151,16 @@ static int64_t Simulate(grid* Grid, beam_array* BeamStack, uint8_t* Visited)
             switch(Beam.Dir)
             {
             case DIR_UP:
-                BeamArrayAdd(BeamStack, Beam.X + 1, Beam.Y, DIR_RIGHT);
+                BeamArrayAdd(BeamStack, (beam){.X = Beam.X + 1, .Y = Beam.Y, .Dir = DIR_RIGHT});
                 break;
             case DIR_RIGHT:
-                BeamArrayAdd(BeamStack, Beam.X, Beam.Y - 1, DIR_UP);
+                BeamArrayAdd(BeamStack, (beam){.X = Beam.X, .Y = Beam.Y - 1, .Dir = DIR_UP});
                 break;
             case DIR_DOWN:
-                BeamArrayAdd(BeamStack, Beam.X - 1, Beam.Y, DIR_LEFT);
+                BeamArrayAdd(BeamStack, (beam){.X = Beam.X - 1, .Y = Beam.Y, .Dir = DIR_LEFT});
                 break;
             case DIR_LEFT:
-                BeamArrayAdd(BeamStack, Beam.X, Beam.Y + 1, DIR_DOWN);
+                BeamArrayAdd(BeamStack, (beam){.X = Beam.X, .Y = Beam.Y + 1, .Dir = DIR_DOWN});
                 break;
             }
             break;
@@ -171,15 +168,15 @@ static int64_t Simulate(grid* Grid, beam_array* BeamStack, uint8_t* Visited)
             switch(Beam.Dir)
             {
             case DIR_UP:
-                BeamArrayAdd(BeamStack, Beam.X, Beam.Y - 1, DIR_UP);
+                BeamArrayAdd(BeamStack, (beam){.X = Beam.X, .Y = Beam.Y - 1, .Dir = DIR_UP});
                 break;
             case DIR_RIGHT:
             case DIR_LEFT:
-                BeamArrayAdd(BeamStack, Beam.X, Beam.Y - 1, DIR_UP);
-                BeamArrayAdd(BeamStack, Beam.X, Beam.Y + 1, DIR_DOWN);
+                BeamArrayAdd(BeamStack, (beam){.X = Beam.X, .Y = Beam.Y - 1, .Dir = DIR_UP});
+                BeamArrayAdd(BeamStack, (beam){.X = Beam.X, .Y = Beam.Y + 1, .Dir = DIR_DOWN});
                 break;
             case DIR_DOWN:
-                BeamArrayAdd(BeamStack, Beam.X, Beam.Y + 1, DIR_DOWN);
+                BeamArrayAdd(BeamStack, (beam){.X = Beam.X, .Y = Beam.Y + 1, .Dir = DIR_DOWN});
                 break;
             }
             break;
@@ -188,38 +185,40 @@ static int64_t Simulate(grid* Grid, beam_array* BeamStack, uint8_t* Visited)
             {
             case DIR_UP:
             case DIR_DOWN:
-                BeamArrayAdd(BeamStack, Beam.X - 1, Beam.Y, DIR_LEFT);
-                BeamArrayAdd(BeamStack, Beam.X + 1, Beam.Y, DIR_RIGHT);
+                BeamArrayAdd(BeamStack, (beam){.X = Beam.X - 1, .Y = Beam.Y, .Dir = DIR_LEFT});
+                BeamArrayAdd(BeamStack, (beam){.X = Beam.X + 1, .Y = Beam.Y, .Dir = DIR_RIGHT});
                 break;
             case DIR_RIGHT:
-                BeamArrayAdd(BeamStack, Beam.X + 1, Beam.Y, DIR_RIGHT);
+                BeamArrayAdd(BeamStack, (beam){.X = Beam.X + 1, .Y = Beam.Y, .Dir = DIR_RIGHT});
                 break;
             case DIR_LEFT:
-                BeamArrayAdd(BeamStack, Beam.X - 1, Beam.Y, DIR_LEFT);
+                BeamArrayAdd(BeamStack, (beam){.X = Beam.X - 1, .Y = Beam.Y, .Dir = DIR_LEFT});
                 break;
             }
             break;
         }
     }
-    uint64_t Energized = 0;
-    for(int Index = 0; Index < Grid->Count; Index++)
-    {
-        Energized += Visited[Index] != 0;
-    }
-    return Energized;
+
+    // A cell is energized if a beam passed through it in any direction.
+    bit_set* Energized = &Visited->Energized;
+    BitSetOr(Energized, &Visited->Dirs[DIR_UP], &Visited->Dirs[DIR_RIGHT]);
+    BitSetOr(Energized, Energized, &Visited->Dirs[DIR_DOWN]);
+    BitSetOr(Energized, Energized, &Visited->Dirs[DIR_LEFT]);
+    return BitSetCount(Energized);
 }
 
 AOC_SOLVER(Part1)
 {
     grid Grid;
     InitGrid(&Grid, Input);
-    uint8_t* Visited = (uint8_t*)malloc(sizeof(uint8_t) * Grid.Count);
+    visited Visited;
+    InitVisited(&Visited, Grid.Count);
     beam_array BeamStack;
     InitBeamArray(&BeamStack);
-    BeamArrayAdd(&BeamStack, 0, 0, DIR_RIGHT);
-    int64_t Result = Simulate(&Grid, &BeamStack, Visited);
+    BeamArrayAdd(&BeamStack, (beam){.X = 0, .Y = 0, .Dir = DIR_RIGHT});
+    int64_t Result = Simulate(&Grid, &BeamStack, &Visited);
     FreeBeamArray(&BeamStack);
-    free(Visited);
+    FreeVisited(&Visited);
     FreeGrid(&Grid);
     return Result;
 }
@@ -233,26 +232,27 @@ AOC_SOLVER(Part2)
 {
     grid Grid;
     InitGrid(&Grid, Input);
-    uint8_t* Visited = (uint8_t*)malloc(sizeof(uint8_t) * Grid.Count);
+    visited Visited;
+    InitVisited(&Visited, Grid.Count);
     beam_array BeamStack;
     InitBeamArray(&BeamStack);
     int64_t Result = 0;
-    for(int X = 0; X < Grid.Width; X++)
+    for(aoc_index X = 0; X < Grid.Width; X++)
     {
-        BeamArrayAdd(&BeamStack, X, 0, DIR_DOWN);
-        Result = Max(Result, Simulate(&Grid, &BeamStack, Visited));
-        BeamArrayAdd(&BeamStack, X, Grid.Height - 1, DIR_UP);
-        Result = Max(Result, Simulate(&Grid, &BeamStack, Visited));
+        BeamArrayAdd(&BeamStack, (beam){.X = X, .Y = 0, .Dir = DIR_DOWN});
+        Result = Max(Result, Simulate(&Grid, &BeamStack, &Visited));
+        BeamArrayAdd(&BeamStack, (beam){.X = X, .Y = Grid.Height - 1, .Dir = DIR_UP});
+        Result = Max(Result, Simulate(&Grid, &BeamStack, &Visited));
     }
-    for(int Y = 0; Y < Grid.Height; Y++)
+    for(aoc_index Y = 0; Y < Grid.Height; Y++)
     {
-        BeamArrayAdd(&BeamStack, 0, Y, DIR_RIGHT);
-        Result = Max(Result, Simulate(&Grid, &BeamStack, Visited));
-        BeamArrayAdd(&BeamStack, Grid.Width - 1, Y, DIR_LEFT);
-        Result = Max(Result, Simulate(&Grid, &BeamStack, Visited));
+        BeamArrayAdd(&BeamStack, (beam){.X = 0, .Y = Y, .Dir = DIR_RIGHT});
+        Result = Max(Result, Simulate(&Grid, &BeamStack, &Visited));
+        BeamArrayAdd(&BeamStack, (beam){.X = Grid.Width - 1, .Y = Y, .Dir = DIR_LEFT});
+        Result = Max(Result, Simulate(&Grid, &BeamStack, &Visited));
     }
     FreeBeamArray(&BeamStack);
-    free(Visited);
+    FreeVisited(&Visited);
     FreeGrid(&Grid);
     return Result;
 }
@@ -11,8 +11,8 @@ typedef struct
     size_t Capacity;
     size_t Count;
     char* Cells;
-    int Width;
-    int Height;
+    aoc_index Width;
+    aoc_index Height;
 } grid;
 
 static void InitGrid(grid* Grid, const char* Input)
@@ -35,7 +35,7 @@ static void InitGrid(grid* Grid, const char* Input)
         Input = SkipPastNewline(Input);
         Grid->Height++;
     }
-    Grid->Width = Grid->Count / Grid->Height;
+    Grid->Width = (aoc_index)Grid->Count / Grid->Height;
 }
 
 static void FreeGrid(grid* Grid)
@@ -55,12 +55,13 @@ enum
 static int MoveX[NUM_DIRS] = {0, 1, 0, -1};
 static int MoveY[NUM_DIRS] = {-1, 0, 1, 0};
 
+// Nodes are hashed and compared as bytes, so their fields leave no padding.
 typedef struct
 {
-    int16_t X;
-    int16_t Y;
-    int8_t Dir;
-    int8_t Cons;
+    int32_t X;
+    int32_t Y;
+    int16_t Dir;
+    int16_t Cons;
 } node;
 
 typedef node key;
@@ -68,8 +69,8 @@ typedef int64_t value;
 
 typedef struct
 {
-    int Count;
-    int Capacity;
+    aoc_index Count;
+    aoc_index Capacity;
     uint8_t* Slots;
     key* Keys;
     value* Values;
@@ -107,7 +108,7 @@ static void TableGrow(table* Table)
     NewTable.Keys = (key*)malloc(sizeof(key) * NewTable.Capacity);
     NewTable.Values = (value*)malloc(sizeof(value) * NewTable.Capacity);
     TableReset(&NewTable);
-    for(int Index = 0; Index < Table->Capacity; Index++)
+    for(aoc_index Index = 0; Index < Table->Capacity; Index++)
     {
         if(Table->Slots[Index])
         {
@@ -124,9 +125,9 @@ static void TableSet(table* Table, key Key, value Value)
     {
         TableGrow(Table);
     }
-    int Hash = (int)XXH3_64bits(&Key, sizeof(key));
-    int CapacityMask = Table->Capacity - 1;
-    int Index = Hash & CapacityMask;
+    uint64_t Hash = XXH3_64bits(&Key, sizeof(key));
+    aoc_index CapacityMask = Table->Capacity - 1;
+    aoc_index Index = (aoc_index)(Hash & CapacityMask);
     for(;;)
     {
         if(Table->Slots[Index])
@@ -152,9 +153,9 @@ static void TableSet(table* Table, key Key, value Value)
 static bool TableGet(table* Table, key Key, value* Value)
 {
     if(Table->Count == 0) return false;
-    uint64_t Hash = (int)XXH3_64bits(&Key, sizeof(key));
-    int CapacityMask = Table->Capacity - 1;
-    int Index = Hash & CapacityMask;
+    uint64_t Hash = XXH3_64bits(&Key, sizeof(key));
+    aoc_index CapacityMask = Table->Capacity - 1;
+    aoc_index Index = (aoc_index)(Hash & CapacityMask);
     for(;;)
     {
         if(Table->Slots[Index])
@@ -207,8 +208,8 @@ static void PriorityQueuePush(priority_queue* Queue, node Node, int64_t Dist)
         Queue->Entries = (entry*)realloc(Queue->Entries, sizeof(entry) * Capacity);
         Queue->Capacity = Capacity;
     }
-    int Index = Queue->Count++;
-    int ParentIndex = (Index - 1) / 2;
+    size_t Index = Queue->Count++;
+    size_t ParentIndex = (Index - 1) / 2;
     while(Index > 0 && Queue->Entries[ParentIndex].Dist > Dist)
     {
         Queue->Entries[Index] = Queue->Entries[ParentIndex];
@@ -222,16 +223,16 @@ static node PriorityQueuePop(priority_queue* Queue)
 {
     node Node = Queue->Entries[0].Node;
     Queue->Entries[0] = Queue->Entries[--Queue->Count];
-    int Index = 0;
+    size_t Index = 0;
     for(;;)
     {
-        int MinIndex = Index;
-        int LeftIndex = 2 * Index + 1;
+        size_t MinIndex = Index;
+        size_t LeftIndex = 2 * Index + 1;
         if(LeftIndex < Queue->Count && Queue->Entries[LeftIndex].Dist < Queue->Entries[MinIndex].Dist)
         {
             MinIndex = LeftIndex;
         }
-        int RightIndex = LeftIndex + 1;
+        size_t RightIndex = LeftIndex + 1;
         if(RightIndex < Queue->Count && Queue->Entries[RightIndex].Dist < Queue->Entries[MinIndex].Dist)
         {
             MinIndex = RightIndex;
@@ -259,8 +260,8 @@ static int64_t Solve(const char* Input, int MinCons, int MaxCons)
         TableSet(&Dist, Source, 0);
         PriorityQueuePush(&Queue, Source, 0);
     }
-    int TargetX = Grid.Width - 1;
-    int TargetY = Grid.Height - 1;
+    aoc_index TargetX = Grid.Width - 1;
+    aoc_index TargetY = Grid.Height - 1;
     int64_t Result = 0;
     while(Queue.Count > 0)
     {
@@ -298,7 +299,7 @@ static int64_t Solve(const char* Input, int MinCons, int MaxCons)
             {
                 NeighborDist = INT64_MAX;
             }
-            int64_t AltDist = CurrDist + Grid.Cells[Neighbor.Y * Grid.Width + Neighbor.X];
+            int64_t AltDist = CurrDist + Grid.Cells[(aoc_index)Neighbor.Y * Grid.Width + Neighbor.X];
             if(AltDist < NeighborDist)
             {
                 TableSet(&Dist, Neighbor, AltDist);
@@ -1,4 +1,5 @@
 #include "aoc.h"
+#include "array.h"
 #include "parse.h"
 
 const char* DefaultInputPath = "d18.txt";
@@ -14,41 +15,8 @@ typedef struct
     int Y;
 } ivec2;
 
-typedef struct
-{
-    int* Elements;
-    size_t Count;
-    size_t Capacity;
-} edge_buffer;
-
-static void InitEdgeBuffer(edge_buffer* Buffer)
-{
-    Buffer->Elements = NULL;
-    Buffer->Count = 0;
-    Buffer->Capacity = 0;
-}
-
-static void FreeEdgeBuffer(edge_buffer* Buffer)
-{
-    free(Buffer->Elements);
-}
-
-static void EdgeBufferAdd(edge_buffer* Buffer, int Element)
-{
-    size_t Capacity = Buffer->Capacity;
-    if(Buffer->Count == Capacity)
-    {
-        Capacity = Capacity ? 2 * Capacity : 8;
-        Buffer->Elements = (int*)realloc(Buffer->Elements, sizeof(int) * Capacity);
-        Buffer->Capacity = Capacity;
-    }
-    Buffer->Elements[Buffer->Count++] = Element;
-}
-
-static void EdgeBufferReset(edge_buffer* Buffer)
-{
-    Buffer->Count = 0;
-}
+SMALL_ARRAY(edge_buffer, EdgeBuffer, int, 32)
+ARRAY(corner_array, CornerArray, ivec2)
 
 static bool CompareCorners(ivec2 A, ivec2 B)
 {
@@ -110,7 +78,7 @@ static int64_t CalculateArea(ivec2* Corners, size_t CornerCount)
         for(int EdgeIndex = 1; EdgeIndex < Edges.Count; EdgeIndex += 2)
         {
             int64_t Width = 1 + Edges.Elements[EdgeIndex] - Edges.Elements[EdgeIndex - 1];
-            Result += Width * Height;
+            Result = AocAdd(Result, AocMul(Width, Height));
         }
 
         // Determine the next edges by merging the current edges with the edges
@@ -153,7 +121,7 @@ static int64_t CalculateArea(ivec2* Corners, size_t CornerCount)
         {
             int LeftEdge = Edges.Elements[EdgeIndex - 1];
             int RightEdge = Edges.Elements[EdgeIndex];
-            Result += 1 + RightEdge - LeftEdge;
+            Result = AocAdd(Result, 1 + (int64_t)RightEdge - LeftEdge);
             for(int NextIndex = 1; NextIndex < NextEdges.Count; NextIndex += 2)
             {
                 int NextLeftEdge = NextEdges.Elements[NextIndex - 1];
@@ -168,9 +136,7 @@ static int64_t CalculateArea(ivec2* Corners, size_t CornerCount)
 
         // Flip edge buffers for next row of boxes.
         Y = NextY;
-        edge_buffer TempEdges = Edges;
-        Edges = NextEdges;
-        NextEdges = TempEdges;
+        EdgeBufferSwap(&Edges, &NextEdges);
         EdgeBufferReset(&NextEdges);
     }
 
@@ -182,9 +148,9 @@ static int64_t CalculateArea(ivec2* Corners, size_t CornerCount)
 
 AOC_SOLVER(Part1)
 {
-    size_t CornerCount = 0;
-    size_t CornerCapacity = 16;
-    ivec2* Corners = (ivec2*)malloc(sizeof(ivec2) * CornerCapacity);
+    corner_array Corners;
+    InitCornerArray(&Corners);
+    CornerArrayReserve(&Corners, strlen(Input) / 14); // At least 14 chars per line.
     ivec2 At = (ivec2){.X = 0, .Y = 0};
     while(IsDir(*Input))
     {
@@ -203,24 +169,19 @@ AOC_SOLVER(Part1)
         case 'L': At.X -= Dist; break;
         case 'U': At.Y -= Dist; break;
         }
-        if(CornerCount == CornerCapacity)
-        {
-            CornerCapacity *= 2;
-            Corners = (ivec2*)realloc(Corners, sizeof(ivec2) * CornerCapacity);
-        }
-        Corners[CornerCount++] = At;
+        CornerArrayAdd(&Corners, At);
         Input = SkipPastNewline(Input + 10);
     }
-    int64_t Result = CalculateArea(Corners, CornerCount);
-    free(Corners);
+    int64_t Result = CalculateArea(Corners.Elements, Corners.Count);
+    FreeCornerArray(&Corners);
     return Result;
 }
 
 AOC_SOLVER(Part2)
 {
-    size_t CornerCount = 0;
-    size_t CornerCapacity = 16;
-    ivec2* Corners = (ivec2*)malloc(sizeof(ivec2) * CornerCapacity);
+    corner_array Corners;
+    InitCornerArray(&Corners);
+    CornerArrayReserve(&Corners, strlen(Input) / 14); // At least 14 chars per line.
     ivec2 At = (ivec2){.X = 0, .Y = 0};
     while(IsDir(*Input))
     {
@@ -246,15 +207,10 @@ AOC_SOLVER(Part2)
         case '2': At.X -= Dist; break;
         case '3': At.Y -= Dist; break;
         }
-        if(CornerCount == CornerCapacity)
-        {
-            CornerCapacity *= 2;
-            Corners = (ivec2*)realloc(Corners, sizeof(ivec2) * CornerCapacity);
-        }
-        Corners[CornerCount++] = At;
+        CornerArrayAdd(&Corners, At);
         Input = SkipPastNewline(Input + 7);
     }
-    int64_t Result = CalculateArea(Corners, CornerCount);
-    free(Corners);
+    int64_t Result = CalculateArea(Corners.Elements, Corners.Count);
+    FreeCornerArray(&Corners);
     return Result;
 }
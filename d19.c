@@ -173,7 +173,7 @@ AOC_SOLVER(Part1)
                 Rule = Workflows[Rule->Id];
                 continue;
             case TARGET_ACCEPT:
-                Result += Ratings[0] + Ratings[1] + Ratings[2] + Ratings[3];
+                Result = AocAdd(Result, (int64_t)Ratings[0] + Ratings[1] + Ratings[2] + Ratings[3]);
                 goto NextPart;
             case TARGET_REJECT:
                 goto NextPart;
@@ -229,16 +229,16 @@ static int64_t AcceptedCombinations(rule** Workflows, rule* Rule, range* Accepte
         // here, count the number of accepted combinations.
         if(Rule->Target == TARGET_WORKFLOW)
         {
-            Result += AcceptedCombinations(Workflows, Workflows[Rule->Id], Accepted);
+            Result = AocAdd(Result, AcceptedCombinations(Workflows, Workflows[Rule->Id], Accepted));
         }
         else if(Rule->Target == TARGET_ACCEPT)
         {
             int64_t Product = 1;
             for(int Index = 0; Index < NUM_RATINGS; Index++)
             {
-                Product *= 1 + Accepted[Index].Max - Accepted[Index].Min;
+                Product = AocMul(Product, 1 + (int64_t)Accepted[Index].Max - Accepted[Index].Min);
             }
-            Result += Product;
+            Result = AocAdd(Result, Product);
         }
 
         // Modify the accepted ranges based on the condition failing.
@@ -1,4 +1,5 @@
 #include "aoc.h"
+#include "graph.h"
 #include "parse.h"
 
 const char* DefaultInputPath = "d20.txt";
@@ -31,11 +32,8 @@ enum
 typedef struct
 {
     uint16_t State;
-    uint16_t OutputIds[7];
-    uint8_t OutputPins[7];
     uint8_t Type;
     uint8_t NumInputs;
-    uint8_t NumOutputs;
 } module;
 
 typedef struct
@@ -120,7 +118,12 @@ typedef bool (*should_push_fn)(void* User, int64_t Push);
 
 static void Solve(const char* Input, should_push_fn ShouldPushFn, on_pulse_fn OnPulseFn, void* User)
 {
-    module* Modules = (module*)calloc(26 * 26 + 1, sizeof(module));
+    // Parse the modules. Their connections form a graph, where the weight of
+    // each edge is the input pin it connects to on the output module.
+    int ModuleCount = 26 * 26 + 1;
+    module* Modules = (module*)calloc(ModuleCount, sizeof(module));
+    graph_builder Builder;
+    InitGraphBuilder(&Builder, ModuleCount);
     while(IsModule(*Input))
     {
         uint8_t Type = *Input++;
@@ -141,12 +144,15 @@ static void Solve(const char* Input, should_push_fn ShouldPushFn, on_pulse_fn On
             uint16_t OutputId;
             Input = ParseId(Input, &OutputId);
             if(*Input == ',') Input += 2;
-            module* OutputModule = &Modules[OutputId];
-            Module->OutputIds[Module->NumOutputs] = OutputId;
-            Module->OutputPins[Module->NumOutputs++] = OutputModule->NumInputs++;
+            GraphBuilderAdd(&Builder, Id, OutputId, Modules[OutputId].NumInputs++);
         }
         Input = SkipPastLine(Input);
     }
+    graph Graph;
+    BuildGraph(&Graph, &Builder, true);
+    FreeGraphBuilder(&Builder);
+
+    // Push the button until instructed to stop.
     pulse_queue Pending;
     InitPulseQueue(&Pending);
     for(int64_t Push = 0; ShouldPushFn(User, Push); Push++)
@@ -156,37 +162,40 @@ static void Solve(const char* Input, should_push_fn ShouldPushFn, on_pulse_fn On
         {
             pulse Pulse = PulseQueuePull(&Pending);
             module* Module = &Modules[Pulse.Id];
+            int FirstSlot = Graph.Offsets[Pulse.Id];
+            int LastSlot = Graph.Offsets[Pulse.Id + 1];
             OnPulseFn(User, Push, Pulse);
             switch(Module->Type)
             {
             case MODULE_BROADCASTER:
-                for(int Index = 0; Index < Module->NumOutputs; Index++)
+                for(int Slot = FirstSlot; Slot < LastSlot; Slot++)
                 {
-                    PulseQueuePush(&Pending, Module->OutputIds[Index], Pulse.Value, Module->OutputPins[Index]);
+                    PulseQueuePush(&Pending, Graph.Targets[Slot], Pulse.Value, Graph.Weights[Slot]);
                 }
                 break;
             case MODULE_FLIP_FLOP:
                 if(!Pulse.Value)
                 {
                     Module->State = 1 - Module->State;
-                    for(int Index = 0; Index < Module->NumOutputs; Index++)
+                    for(int Slot = FirstSlot; Slot < LastSlot; Slot++)
                     {
-                        PulseQueuePush(&Pending, Module->OutputIds[Index], (uint8_t)Module->State, Module->OutputPins[Index]);
+                        PulseQueuePush(&Pending, Graph.Targets[Slot], (uint8_t)Module->State, Graph.Weights[Slot]);
                     }
                 }
                 break;
             case MODULE_CONJUNCTION:
                 Module->State = (Module->State & ~(1 << Pulse.Pin)) | (Pulse.Value << Pulse.Pin);
                 uint8_t All = __popcnt16(Module->State) != Module->NumInputs;
-                for(int Index = 0; Index < Module->NumOutputs; Index++)
+                for(int Slot = FirstSlot; Slot < LastSlot; Slot++)
                 {
-                    PulseQueuePush(&Pending, Module->OutputIds[Index], All, Module->OutputPins[Index]);
+                    PulseQueuePush(&Pending, Graph.Targets[Slot], All, Graph.Weights[Slot]);
                 }
                 break;
             }
         }
     }
     FreePulseQueue(&Pending);
+    FreeGraph(&Graph);
     free(Modules);
 }
 
@@ -27,8 +27,8 @@ typedef struct
     size_t Capacity;
     size_t Count;
     char* Cells;
-    int Width;
-    int Height;
+    aoc_index Width;
+    aoc_index Height;
     ivec2 Start;
 } grid;
 
@@ -234,9 +234,9 @@ AOC_SOLVER(Part1)
 
 static bool GridIsNotRockInfinite(grid* Grid, ivec2 Key)
 {
-    int X = Key.X % Grid->Width;
+    aoc_index X = Key.X % Grid->Width;
     if(X < 0) X += Grid->Width;
-    int Y = Key.Y % Grid->Height;
+    aoc_index Y = Key.Y % Grid->Height;
     if(Y < 0) Y += Grid->Height;
     return Grid->Cells[Y * Grid->Width + X] != '#';
 }
@@ -251,8 +251,8 @@ AOC_SOLVER(Part2)
     InitTable(&Tables[1]);
     int TableIndex = 0;
     TableSet(&Tables[TableIndex], (key){.X = Grid.Start.X, .Y = Grid.Start.Y}, 1);
-    int* Deltas = (int*)malloc(sizeof(int) * Grid.Width);
-    int* DeltaDeltas = (int*)malloc(sizeof(int) * Grid.Width);
+    int64_t* Deltas = (int64_t*)malloc(sizeof(int64_t) * Grid.Width);
+    int64_t* DeltaDeltas = (int64_t*)malloc(sizeof(int64_t) * Grid.Width);
     for(int64_t Step = 0; Step < Grid.Width * 2; Step++)
     {
         table* From = &Tables[TableIndex];
@@ -284,8 +284,8 @@ AOC_SOLVER(Part2)
                 TableSet(To, West, 1);
             }
         }
-        int DeltaIndex = Step % Grid.Width;
-        int NewDelta = To->Count - From->Count;
+        aoc_index DeltaIndex = Step % Grid.Width;
+        int64_t NewDelta = To->Count - From->Count;
         if(Step >= Grid.Width)
         {
             DeltaDeltas[DeltaIndex] = NewDelta - Deltas[DeltaIndex];
@@ -295,9 +295,9 @@ AOC_SOLVER(Part2)
     int64_t Result = Tables[TableIndex].Count;
     for(int64_t Step = Grid.Width * 2; Step < NumSteps; Step++)
     {
-        int DeltaIndex = Step % Grid.Width;
+        aoc_index DeltaIndex = Step % Grid.Width;
         Deltas[DeltaIndex] += DeltaDeltas[DeltaIndex];
-        Result += Deltas[DeltaIndex];
+        Result = AocAdd(Result, Deltas[DeltaIndex]);
     }
     free(DeltaDeltas);
     free(Deltas);
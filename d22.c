@@ -1,4 +1,5 @@
 #include "aoc.h"
+#include "array.h"
 #include "parse.h"
 
 const char* DefaultInputPath = "d22.txt";
@@ -22,12 +23,7 @@ typedef struct brick
     int Unsafe;
 } brick;
 
-typedef struct
-{
-    brick* Elements;
-    size_t Count;
-    size_t Capacity;
-} brick_array;
+ARRAY(brick_array, BrickArray, brick)
 
 typedef struct
 {
@@ -35,30 +31,6 @@ typedef struct
     int Height;
 } depth_cell;
 
-static void InitBrickArray(brick_array* Array)
-{
-    Array->Elements = NULL;
-    Array->Count = 0;
-    Array->Capacity = 0;
-}
-
-static void FreeBrickArray(brick_array* Array)
-{
-    free(Array->Elements);
-}
-
-static void BrickArrayAdd(brick_array* Array, coord Start, coord End)
-{
-    size_t Capacity = Array->Capacity;
-    if(Array->Count == Capacity)
-    {
-        Capacity = Capacity ? 2 * Capacity : 8;
-        Array->Elements = (brick*)realloc(Array->Elements, sizeof(brick) * Capacity);
-        Array->Capacity = Capacity;
-    }
-    Array->Elements[Array->Count++] = (brick){.Start = Start, .End = End};
-}
-
 static void BricksSwap(brick* Bricks, int FromIndex, int ToIndex)
 {
     brick Temp = Bricks[ToIndex];
@@ -135,6 +107,7 @@ brick_array SimulateBricks(const char* Input)
     // ground.
     brick_array Bricks;
     InitBrickArray(&Bricks);
+    BrickArrayReserve(&Bricks, strlen(Input) / 12); // At least 12 chars per brick.
     int MaxX = INT32_MIN;
     int MaxY = INT32_MIN;
     while(IsDigit(*Input))
@@ -145,7 +118,7 @@ brick_array SimulateBricks(const char* Input)
         Input = SkipPastNewline(Input);
         MaxX = Max(Start.X, Max(End.X, MaxX));
         MaxY = Max(Start.Y, Max(End.Y, MaxY));
-        BrickArrayAdd(&Bricks, Start, End);
+        BrickArrayAdd(&Bricks, (brick){.Start = Start, .End = End});
     }
     BrickArraySort(&Bricks);
 
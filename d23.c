@@ -1,4 +1,7 @@
 #include "aoc.h"
+#include "array.h"
+#include "bitset.h"
+#include "graph.h"
 #include "parse.h"
 
 const char* DefaultInputPath = "d23.txt";
@@ -64,14 +67,13 @@ static int MoveY[NUM_DIRS] = {-1, 0, 1, 0};
 
 typedef struct
 {
-    int16_t X;
-    int16_t Y;
-    int16_t NeighborCount;
-    int16_t NeighborIndices[NUM_DIRS];
-    int16_t NeighborDists[NUM_DIRS];
+    int X;
+    int Y;
 } node;
 
-static bool FindBranchingPoint(grid* Grid, int16_t* Lookup, int X, int Y, int Dist, int InDir, int16_t* OutIndex, int16_t* OutDist)
+SMALL_ARRAY(node_array, NodeArray, node, 64)
+
+static bool FindBranchingPoint(grid* Grid, int* Lookup, int X, int Y, int Dist, int InDir, int* OutIndex, int* OutDist)
 {
     if(X < 0 || X >= Grid->Width) return false;
     if(Y < 0 || Y >= Grid->Height) return false;
@@ -107,17 +109,17 @@ static bool FindBranchingPoint(grid* Grid, int16_t* Lookup, int X, int Y, int Di
     return false;
 }
 
-static int64_t FindLongestPath(node* Nodes, int NodeIndex, int TargetNodeIndex, uint64_t Visited, int Dist)
+static int64_t FindLongestPath(graph* Graph, int NodeIndex, int TargetNodeIndex, bit_set* Visited, int64_t Dist)
 {
     if(NodeIndex == TargetNodeIndex) return Dist;
     int64_t MaxDist = 0;
-    node Node = Nodes[NodeIndex];
-    for(int Index = 0; Index < Node.NeighborCount; Index++)
+    for(int Slot = Graph->Offsets[NodeIndex]; Slot < Graph->Offsets[NodeIndex + 1]; Slot++)
     {
-        int NeighborIndex = Node.NeighborIndices[Index];
-        uint64_t NeighborMask = 1ull << NeighborIndex;
-        if(Visited & NeighborMask) continue;
-        int NeighborDist = FindLongestPath(Nodes, NeighborIndex, TargetNodeIndex, Visited | NeighborMask, Dist + Node.NeighborDists[Index]);
+        int NeighborIndex = Graph->Targets[Slot];
+        if(BitSetContains(Visited, NeighborIndex)) continue;
+        BitSetSet(Visited, NeighborIndex);
+        int64_t NeighborDist = FindLongestPath(Graph, NeighborIndex, TargetNodeIndex, Visited, Dist + Graph->Weights[Slot]);
+        BitSetClear(Visited, NeighborIndex);
         MaxDist = NeighborDist > MaxDist ? NeighborDist : MaxDist;
     }
     return MaxDist;
@@ -141,10 +143,9 @@ static int64_t Solve(const char* Input, bool RemoveSlopes)
     }
 
     // Find branching points in the graph.
-    size_t NodeCount = 0;
-    size_t NodeCapacity = 64;
-    node* Nodes = (node*)malloc(sizeof(node) * NodeCapacity);
-    int16_t* NodeLookup = (int16_t*)calloc(Grid.Count, sizeof(int16_t));
+    node_array NodeArray;
+    InitNodeArray(&NodeArray);
+    int* NodeLookup = (int*)calloc(Grid.Count, sizeof(int));
     int GridIndex = 0;
     for(int Y = 0; Y < Grid.Height; Y++)
     {
@@ -167,39 +168,46 @@ static int64_t Solve(const char* Input, bool RemoveSlopes)
             }
             if(NumNeighbors > 2 || (X == 1 && Y == 0) || (X == Grid.Width - 2 && Y == Grid.Height - 1))
             {
-                if(NodeCount == NodeCapacity)
-                {
-                    NodeCapacity *= 2;
-                    Nodes = (node*)realloc(Nodes, sizeof(node) * NodeCapacity);
-                }
-                Nodes[NodeCount] = (node){.X = X, .Y = Y, .NeighborCount = 0};
+                NodeLookup[GridIndex] = NodeArray.Count;
+                NodeArrayAdd(&NodeArray, (node){.X = X, .Y = Y});
                 Grid.Cells[GridIndex] = '+';
-                NodeLookup[GridIndex] = NodeCount++;
             }
         }
     }
 
-    // Form a smaller graph consisting only of the branching points.
+    // Form a smaller graph consisting only of the branching points, weighted
+    // by the distance between them.
+    node* Nodes = NodeArray.Elements;
+    int NodeCount = NodeArray.Count;
+    graph_builder Builder;
+    InitGraphBuilder(&Builder, NodeCount);
+    GraphBuilderReserve(&Builder, NUM_DIRS * NodeCount);
     for(int NodeIndex = 0; NodeIndex < NodeCount; NodeIndex++)
     {
         node* Node = &Nodes[NodeIndex];
         for(int Dir = 0; Dir < NUM_DIRS; Dir++)
         {
-            int16_t NeighborIndex, NeighborDist;
+            int NeighborIndex, NeighborDist;
             if(FindBranchingPoint(&Grid, NodeLookup, Node->X + MoveX[Dir], Node->Y + MoveY[Dir], 1, Dir, &NeighborIndex, &NeighborDist))
             {
-                Node->NeighborIndices[Node->NeighborCount] = NeighborIndex;
-                Node->NeighborDists[Node->NeighborCount] = NeighborDist;
-                Node->NeighborCount++;
+                GraphBuilderAdd(&Builder, NodeIndex, NeighborIndex, NeighborDist);
             }
         }
     }
+    graph Graph;
+    BuildGraph(&Graph, &Builder, true);
+    FreeGraphBuilder(&Builder);
 
     // Find the longest path using depth-first search.
-    int64_t Result = FindLongestPath(Nodes, 0, NodeCount - 1, 1ull, 0);
+    bit_set Visited;
+    InitBitSet(&Visited, NodeCount);
+    BitSetSet(&Visited, 0);
+    int64_t Result = FindLongestPath(&Graph, 0, NodeCount - 1, &Visited, 0);
+    FreeBitSet(&Visited);
+    FreeGraph(&Graph);
 
     free(NodeLookup);
-    free(Nodes);
+    FreeNodeArray(&NodeArray);
     FreeGrid(&Grid);
     return Result;
 }
@@ -1,4 +1,5 @@
 #include "aoc.h"
+#include "array.h"
 #include "parse.h"
 
 const char* DefaultInputPath = "d24.txt";
@@ -33,35 +34,16 @@ const char* ParseVector(const char* Input, vec3* OutVector)
     return ParseNumber(Input + 2, &OutVector->Z);
 }
 
-typedef struct
-{
-    hailstone* Elements;
-    size_t Count;
-    size_t Capacity;
-} hailstone_array;
-
-static hailstone* HailstoneArrayAdd(hailstone_array* Array)
-{
-    size_t Capacity = Array->Capacity;
-    if(Array->Count == Capacity)
-    {
-        Capacity = Capacity ? 2 * Capacity : 8;
-        Array->Elements = (hailstone*)realloc(Array->Elements, sizeof(hailstone) * Capacity);
-        Array->Capacity = Capacity;
-    }
-    return &Array->Elements[Array->Count++];
-}
+ARRAY(hailstone_array, HailstoneArray, hailstone)
 
-static void InitHailstoneArray(hailstone_array* Array, const char* Input)
+static void ParseHailstones(hailstone_array* Hailstones, const char* Input)
 {
-    Array->Elements = NULL;
-    Array->Count = 0;
-    Array->Capacity = 0;
+    HailstoneArrayReserve(Hailstones, strlen(Input) / 24); // At least 24 chars per line.
     while(IsDigit(*Input))
     {
         while(IsDigit(*Input))
         {
-            hailstone* Hailstone = HailstoneArrayAdd(Array);
+            hailstone* Hailstone = HailstoneArrayPush(Hailstones);
             Input = ParseVector(Input, &Hailstone->Position);
             Input = ParseVector(Input + 3, &Hailstone->Velocity);
             Input = SkipPastNewline(Input);
@@ -69,11 +51,6 @@ static void InitHailstoneArray(hailstone_array* Array, const char* Input)
     }
 }
 
-static void FreeHailstoneArray(hailstone_array* Array)
-{
-    free(Array->Elements);
-}
-
 AOC_SOLVER(Part1)
 {
     double RangeMin = 200000000000000;
@@ -86,7 +63,8 @@ AOC_SOLVER(Part1)
     }
 
     hailstone_array Hailstones;
-    InitHailstoneArray(&Hailstones, Input);
+    InitHailstoneArray(&Hailstones);
+    ParseHailstones(&Hailstones, Input);
 
     int64_t Result = 0;
     for(int IndexA = 0; IndexA < Hailstones.Count; IndexA++)
@@ -139,7 +117,8 @@ AOC_SOLVER(Part1)
 AOC_SOLVER(Part2)
 {
     hailstone_array Hailstones;
-    InitHailstoneArray(&Hailstones, Input);
+    InitHailstoneArray(&Hailstones);
+    ParseHailstones(&Hailstones, Input);
 
     // Every hailstone adds 3 equations and 1 unknown (time). There are 6 base
     // unknowns (3 position + 3 velocity). To solve the system of equations,
@@ -1,4 +1,6 @@
 #include "aoc.h"
+#include "bitset.h"
+#include "graph.h"
 #include "parse.h"
 
 #include <time.h>
@@ -46,12 +48,6 @@ static const char* ParseVertex(const char* Input, vertex_lookup* Lookup, int* Ou
     return Input;
 }
 
-typedef struct
-{
-    int From;
-    int To;
-} edge;
-
 typedef struct
 {
     size_t Count;
@@ -116,16 +112,16 @@ static int VertexQueuePull(vertex_queue* Queue)
     return Vertex;
 }
 
-static int CountConnected(int Vertex, int VertexCount, int* Adj, uint8_t* Visited)
+static int CountConnected(graph* Graph, int Vertex, bit_set* Removed, bit_set* Visited)
 {
-    Visited[Vertex] = true;
-    int* VertexAdj = &Adj[Vertex * VertexCount];
+    BitSetSet(Visited, Vertex);
     int Count = 1;
-    for(int Neighbor = 0; Neighbor < VertexCount; Neighbor++)
+    for(int Slot = Graph->Offsets[Vertex]; Slot < Graph->Offsets[Vertex + 1]; Slot++)
     {
-        if(Visited[Neighbor]) continue;
-        if(!VertexAdj[Neighbor]) continue;
-        Count += CountConnected(Neighbor, VertexCount, Adj, Visited);
+        int Neighbor = Graph->Targets[Slot];
+        if(BitSetContains(Visited, Neighbor)) continue;
+        if(BitSetContains(Removed, Graph->EdgeIds[Slot])) continue;
+        Count += CountConnected(Graph, Neighbor, Removed, Visited);
     }
     return Count;
 }
@@ -135,9 +131,9 @@ AOC_SOLVER(Part1)
     // Parse all vertices and edges from the input.
     vertex_lookup Lookup;
     InitVertexLookup(&Lookup);
-    size_t EdgeCount = 0;
-    size_t EdgeCapacity = 8;
-    edge* Edges = (edge*)malloc(sizeof(edge) * EdgeCapacity);
+    graph_builder Builder;
+    InitGraphBuilder(&Builder, 0);
+    GraphBuilderReserve(&Builder, strlen(Input) / 2); // 2 slots per 4 chars.
     while(IsLower(*Input))
     {
         int FromVertex;
@@ -146,39 +142,37 @@ AOC_SOLVER(Part1)
         {
             int ToVertex;
             Input = SkipPastWhitespace(ParseVertex(Input, &Lookup, &ToVertex));
-            if(EdgeCount == EdgeCapacity)
-            {
-                EdgeCapacity *= 2;
-                Edges = (edge*)realloc(Edges, sizeof(edge) * EdgeCapacity);
-            }
-            Edges[EdgeCount++] = (edge){.From = FromVertex, .To = ToVertex};
+            GraphBuilderAddUndirected(&Builder, FromVertex, ToVertex, 0);
         }
         Input = SkipPastNewline(Input);
     }
 
-    // Form an adjacency matrix from the edges.
-    int* Adj = (int*)calloc(Lookup.VertexCount * Lookup.VertexCount, sizeof(int));
-    for(int EdgeIndex = 0; EdgeIndex < EdgeCount; EdgeIndex++)
-    {
-        edge Edge = Edges[EdgeIndex];
-        Adj[Edge.From * Lookup.VertexCount + Edge.To] = EdgeIndex + 1;
-        Adj[Edge.To * Lookup.VertexCount + Edge.From] = EdgeIndex + 1;
-    }
+    // Form a compressed sparse row graph from the edges. Edges are removed
+    // from the graph by marking their ids in a bit set.
+    int EdgeCount = Builder.IdCount;
+    graph Graph;
+    BuildGraph(&Graph, &Builder, false);
+    FreeGraphBuilder(&Builder);
+    bit_set Removed;
+    InitBitSet(&Removed, EdgeCount);
 
     // Find paths between random vertices in the graph. Count the frequency of
     // edges encountered. Edges in the min-cut have a high chance of appearing
     // in one of these paths because they are bridges between the two connected
     // sub-graphs, which will be taken if the randomly selected vertices are
     // in different halves of the graph.
-    int* Frequency = (int*)malloc(sizeof(int) * EdgeCount);
-    int* Prev = (int*)malloc(sizeof(int) * Lookup.VertexCount);
-    int* Dist = (int*)malloc(sizeof(int) * Lookup.VertexCount);
+    arena Arena;
+    InitArena(&Arena, sizeof(int) * (EdgeCount + 3 * Lookup.VertexCount));
+    int* Frequency = (int*)ArenaPush(&Arena, sizeof(int) * EdgeCount);
+    int* Prev = (int*)ArenaPush(&Arena, sizeof(int) * Lookup.VertexCount);
+    int* PrevEdge = (int*)ArenaPush(&Arena, sizeof(int) * Lookup.VertexCount);
+    int* Dist = (int*)ArenaPush(&Arena, sizeof(int) * Lookup.VertexCount);
     vertex_queue Queue;
     InitVertexQueue(&Queue);
-    uint8_t* Visited = (uint8_t*)malloc(sizeof(uint8_t) * Lookup.VertexCount);
+    bit_set Visited;
+    InitBitSet(&Visited, Lookup.VertexCount);
     srand(time(NULL));
     int NumIterations = 5;
-    int RemovedEdgeIndices[3];
     int Connected;
     for(;;)
     {
@@ -207,15 +201,17 @@ AOC_SOLVER(Part1)
                 {
                     int Vertex = VertexQueuePull(&Queue);
                     if(Vertex == Sink) break;
-                    int* VertexAdj = &Adj[Vertex * Lookup.VertexCount];
-                    for(int Neighbor = 0; Neighbor < Lookup.VertexCount; Neighbor++)
+                    for(int Slot = Graph.Offsets[Vertex]; Slot < Graph.Offsets[Vertex + 1]; Slot++)
                     {
-                        if(!VertexAdj[Neighbor]) continue;
+                        int EdgeId = Graph.EdgeIds[Slot];
+                        if(BitSetContains(&Removed, EdgeId)) continue;
+                        int Neighbor = Graph.Targets[Slot];
                         int AltDist = Dist[Vertex] + 1;
                         if(AltDist < Dist[Neighbor])
                         {
                             Dist[Neighbor] = AltDist;
                             Prev[Neighbor] = Vertex;
+                            PrevEdge[Neighbor] = EdgeId;
                             VertexQueuePush(&Queue, Neighbor);
                         }
                     }
@@ -226,10 +222,8 @@ AOC_SOLVER(Part1)
                 int Vertex = Sink;
                 while(Vertex != Source)
                 {
-                    int PrevVertex = Prev[Vertex];
-                    int EdgeIndex = Adj[PrevVertex * Lookup.VertexCount + Vertex] - 1;
-                    Frequency[EdgeIndex]++;
-                    Vertex = PrevVertex;
+                    Frequency[PrevEdge[Vertex]]++;
+                    Vertex = Prev[Vertex];
                 }
             }
 
@@ -247,27 +241,18 @@ AOC_SOLVER(Part1)
             }
 
             // Remove the highest frequency edge from the graph.
-            edge MaxEdge = Edges[MaxEdgeIndex];
-            Adj[MaxEdge.From * Lookup.VertexCount + MaxEdge.To] = 0;
-            Adj[MaxEdge.To * Lookup.VertexCount + MaxEdge.From] = 0;
+            BitSetSet(&Removed, MaxEdgeIndex);
             Frequency[MaxEdgeIndex] = 0;
-            RemovedEdgeIndices[Phase] = MaxEdgeIndex;
         }
 
         // Stop iterating if we've split the graph.
-        memset(Visited, 0, sizeof(uint8_t) * Lookup.VertexCount);
-        Connected = CountConnected(0, Lookup.VertexCount, Adj, Visited);
+        BitSetFill(&Visited, false);
+        Connected = CountConnected(&Graph, 0, &Removed, &Visited);
         if(Connected < Lookup.VertexCount) break;
 
-        // The graph isn't split - reset the clock! Restore the adjacency
-        // matrix and increase the number of iterations.
-        for(int Phase = 0; Phase < 3; Phase++)
-        {
-            int EdgeIndex = RemovedEdgeIndices[Phase];
-            edge Edge = Edges[EdgeIndex];
-            Adj[Edge.From * Lookup.VertexCount + Edge.To] = EdgeIndex + 1;
-            Adj[Edge.To * Lookup.VertexCount + Edge.From] = EdgeIndex + 1;
-        }
+        // The graph isn't split - reset the clock! Restore the removed edges
+        // and increase the number of iterations.
+        BitSetFill(&Removed, false);
         NumIterations++;
     }
 
@@ -277,13 +262,11 @@ AOC_SOLVER(Part1)
     int64_t Result = (Lookup.VertexCount - Connected) * Connected;
 
     // On the first day of Christmas, my true love gave to me: dynamic memory.
-    free(Visited);
+    FreeBitSet(&Visited);
     FreeVertexQueue(&Queue);
-    free(Dist);
-    free(Prev);
-    free(Frequency);
-    free(Adj);
-    free(Edges);
+    FreeArena(&Arena);
+    FreeBitSet(&Removed);
+    FreeGraph(&Graph);
     FreeVertexLookup(&Lookup);
 
     return Result;
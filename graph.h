@@ -0,0 +1,121 @@
+#pragma once
+
+#include "array.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+// Graphs in compressed sparse row form. The outgoing edges of vertex V occupy
+// slots Offsets[V] to Offsets[V + 1] - 1 of the Targets, EdgeIds and (if the
+// graph is weighted) Weights arrays, in the order they were added.
+typedef struct
+{
+    int VertexCount;
+    int EdgeCount;
+    int* Offsets;
+    int* Targets;
+    int* EdgeIds;
+    int* Weights;
+} graph;
+
+typedef struct
+{
+    int From;
+    int To;
+    int Id;
+    int Weight;
+} graph_edge;
+
+ARRAY(graph_edge_array, GraphEdgeArray, graph_edge)
+
+// Collects an edge list, then builds a graph from it in one counting sort.
+typedef struct
+{
+    graph_edge_array Edges;
+    int VertexCount;
+    int IdCount;
+} graph_builder;
+
+static inline void InitGraphBuilder(graph_builder* Builder, int VertexCount)
+{
+    InitGraphEdgeArray(&Builder->Edges);
+    Builder->VertexCount = VertexCount;
+    Builder->IdCount = 0;
+}
+
+static inline void FreeGraphBuilder(graph_builder* Builder)
+{
+    FreeGraphEdgeArray(&Builder->Edges);
+}
+
+static inline void GraphBuilderReserve(graph_builder* Builder, size_t EdgeCount)
+{
+    GraphEdgeArrayReserve(&Builder->Edges, EdgeCount);
+}
+
+static inline void GraphBuilderAddVertex(graph_builder* Builder, int Vertex)
+{
+    if(Vertex >= Builder->VertexCount) Builder->VertexCount = Vertex + 1;
+}
+
+// Adds a directed edge, returning its id.
+static inline int GraphBuilderAdd(graph_builder* Builder, int From, int To, int Weight)
+{
+    GraphBuilderAddVertex(Builder, From);
+    GraphBuilderAddVertex(Builder, To);
+    int Id = Builder->IdCount++;
+    GraphEdgeArrayAdd(&Builder->Edges, (graph_edge){.From = From, .To = To, .Id = Id, .Weight = Weight});
+    return Id;
+}
+
+// Adds an edge in both directions. Both directions share the returned id.
+static inline int GraphBuilderAddUndirected(graph_builder* Builder, int A, int B, int Weight)
+{
+    int Id = GraphBuilderAdd(Builder, A, B, Weight);
+    GraphEdgeArrayAdd(&Builder->Edges, (graph_edge){.From = B, .To = A, .Id = Id, .Weight = Weight});
+    return Id;
+}
+
+static inline void BuildGraph(graph* Graph, graph_builder* Builder, bool Weighted)
+{
+    int VertexCount = Builder->VertexCount;
+    int EdgeCount = (int)Builder->Edges.Count;
+    graph_edge* Edges = Builder->Edges.Elements;
+    Graph->VertexCount = VertexCount;
+    Graph->EdgeCount = EdgeCount;
+    Graph->Offsets = (int*)calloc(VertexCount + 1, sizeof(int));
+    Graph->Targets = (int*)malloc(sizeof(int) * EdgeCount);
+    Graph->EdgeIds = (int*)malloc(sizeof(int) * EdgeCount);
+    Graph->Weights = Weighted ? (int*)malloc(sizeof(int) * EdgeCount) : NULL;
+
+    // Count the out-degree of each vertex and prefix sum them into offsets.
+    for(int Index = 0; Index < EdgeCount; Index++)
+    {
+        Graph->Offsets[Edges[Index].From + 1]++;
+    }
+    for(int Vertex = 0; Vertex < VertexCount; Vertex++)
+    {
+        Graph->Offsets[Vertex + 1] += Graph->Offsets[Vertex];
+    }
+
+    // Scatter the edges into their slots, preserving their order per vertex.
+    int* Cursors = (int*)malloc(sizeof(int) * (VertexCount + 1));
+    memcpy(Cursors, Graph->Offsets, sizeof(int) * (VertexCount + 1));
+    for(int Index = 0; Index < EdgeCount; Index++)
+    {
+        graph_edge Edge = Edges[Index];
+        int Slot = Cursors[Edge.From]++;
+        Graph->Targets[Slot] = Edge.To;
+        Graph->EdgeIds[Slot] = Edge.Id;
+        if(Weighted) Graph->Weights[Slot] = Edge.Weight;
+    }
+    free(Cursors);
+}
+
+static inline void FreeGraph(graph* Graph)
+{
+    free(Graph->Offsets);
+    free(Graph->Targets);
+    free(Graph->EdgeIds);
+    free(Graph->Weights);
+}
@@ -54,6 +54,15 @@ treb7uchet"""
 
 test(1, 1, d01_e1, "142")
 
+# Lines spanning several 32-byte blocks, a line without digits and a trailing
+# newline.
+d01_e3 = """abcdefghijklmnopqrstuvwxyzabcdefghij4klmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyz
+nodigitsonthislineatallnodigitsonthislineatall
+1abcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyz9
+"""
+
+test(1, 1, d01_e3, "63")
+
 d01_e2 = """two1nine
 eightwothree
 abcone2threexyz
@@ -73,6 +82,30 @@ Game 5: 6 red, 1 blue, 3 green; 2 blue, 1 red, 2 green"""
 test(2, 1, d02_e1, "8")
 test(2, 2, d02_e1, "2286")
 
+d02_e2 = d02_e1 + """
+Bag: 12 red, 13 green, 14 blue
+Bag: 20 red, 20 green, 20 blue
+Bag: 4 red, 3 green, 6 blue
+Bag: 1 blue, 1 red, 1 green
+Bag: 6 red, 3 green, 6 blue"""
+
+test(2, 1, d02_e2, "8\n15\n3\n0\n8")
+test(2, 2, d02_e2, "2286")
+
+d02_e3 = "\n".join(f"Game {i}: {i} red, {i} green; {i} blue" for i in range(1, 201)) + """
+Bag: 100 red, 150 green, 200 blue
+Bag: 200 red, 200 green, 200 blue
+Bag: 0 red, 0 green, 0 blue
+Bag: 199 red, 50 green, 200 blue"""
+
+test(2, 1, d02_e3, "5050\n20100\n0\n1275")
+
+d02_e4 = """Game 1: 2000 red, 2000 green, 2000 blue
+Game 2: 3 red, 4 green; 5 blue"""
+
+test(2, 1, d02_e4, "2")
+test(2, 2, d02_e4, "8000000060")
+
 d03_e1 = """467..114..
 ...*......
 ..35..633.
@@ -87,6 +120,11 @@ d03_e1 = """467..114..
 test(3, 1, d03_e1, "4361")
 test(3, 2, d03_e1, "467835")
 
+d03_e2 = "3000000000*3000000000"
+
+test(3, 1, d03_e2, "6000000000")
+test(3, 2, d03_e2, "9000000000000000000")
+
 d04_e1 = """Card 1: 41 48 83 86 17 | 83 86  6 31 17  9 48 53
 Card 2: 13 32 20 16 61 | 61 30 68 82 17 32 24 19
 Card 3:  1 21 53 59 44 | 69 82 63 72 16 21 14  1
@@ -97,6 +135,23 @@ Card 6: 31 18 13 56 72 | 74 77 10 23 35 67 36 11"""
 test(4, 1, d04_e1, "13")
 test(4, 2, d04_e1, "30")
 
+d04_e2 = """Card 1: 18446744073709551615 5 100000 | 18446744073709551615 5 7 100000
+Card 2: 1 | 2"""
+
+test(4, 1, d04_e2, "4")
+
+d04_e3 = """Card 1: 41 48 | 41 41 48  1
+Card 2: 41 48 | 41 41 48  1
+Card 3: 100 5 100000 | 100 100 5 5 7 100000 100000"""
+
+test(4, 1, d04_e3, "8")
+test(4, 2, d04_e3, "7")
+
+d04_e4 = """Card 1: 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 19 20 21 22 23 24 25 26 27 28 29 30 31 32 33 34 35 36 37 38 39 40 | 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 19 20 21 22 23 24 25 26 27 28 29 30 31 32 33 34 35 36 37 38 39 40"""
+
+test(4, 1, d04_e4, "549755813888")
+test(4, 2, d04_e4, "1")
+
 d05_e1 = """seeds: 79 14 55 13
 
 seed-to-soil map:
@@ -134,12 +189,23 @@ humidity-to-location map:
 test(5, 1, d05_e1, "35")
 test(5, 2, d05_e1, "46")
 
+# Overlapping and touching seed ranges.
+d05_e2 = d05_e1.replace("seeds: 79 14 55 13", "seeds: 79 14 55 13 85 20 60 10 93 0")
+
+test(5, 2, d05_e2, "19")
+
 d06_e1 = """Time:      7  15   30
 Distance:  9  40  200"""
 
 test(6, 1, d06_e1, "288")
 test(6, 2, d06_e1, "71503")
 
+# A time whose square doesn't fit in 64 bits.
+d06_e2 = """Time:      40000 00000
+Distance:  3999999999 999999999"""
+
+test(6, 2, d06_e2, "1")
+
 d07_e1 = """32T3K 765
 T55J5 684
 KK677 28
@@ -149,6 +215,12 @@ QQQJA 483"""
 test(7, 1, d07_e1, "6440")
 test(7, 2, d07_e1, "5905")
 
+# Winnings beyond 32 bits: 3000 tied hands bidding 999 win 999 * (1 + ... + 3000).
+d07_e2 = "AAAAA 999\n" * 3000
+
+test(7, 1, d07_e2, "4496998500")
+test(7, 2, d07_e2, "4496998500")
+
 d08_e1 = """RL
 
 AAA = (BBB, CCC)
@@ -181,6 +253,21 @@ XXX = (XXX, XXX)"""
 
 test(8, 2, d08_e3, "6")
 
+# Ghosts whose cycles don't start at their first target.
+d08_e4 = """L
+
+AAA = (BBB, BBB)
+BBB = (CCZ, CCZ)
+CCZ = (DDB, DDB)
+DDB = (EEB, EEB)
+EEB = (CCZ, CCZ)
+KKA = (LLB, LLB)
+LLB = (MMB, MMB)
+MMB = (NNZ, NNZ)
+NNZ = (MMB, MMB)"""
+
+test(8, 2, d08_e4, "5")
+
 d09_e1 = """0 3 6 9 12 15
 1 3 6 10 15 21
 10 13 16 21 30 45"""
@@ -188,6 +275,17 @@ d09_e1 = """0 3 6 9 12 15
 test(9, 1, d09_e1, "114")
 test(9, 2, d09_e1, "2")
 
+# A sequence of a different length.
+d09_e2 = d09_e1 + "\n5 1 -3"
+
+test(9, 1, d09_e2, "107")
+test(9, 2, d09_e2, "11")
+
+# Differences that don't fit in 64 bits.
+d09_e3 = "5000000000000000000 -5000000000000000000 -5000000000000000000"
+
+test(9, 1, d09_e3, "5000000000000000000")
+
 d10_e1 = """.....
 .S-7.
 .|.|.
@@ -250,6 +348,13 @@ test(10, 2, d10_e4, "4")
 test(10, 2, d10_e5, "8")
 test(10, 2, d10_e6, "10")
 
+d10_e7 = """F----S---7
+|........|
+L--------J"""
+
+test(10, 1, d10_e7, "11")
+test(10, 2, d10_e7, "8")
+
 d11_e1 = """...#......
 .......#..
 #.........